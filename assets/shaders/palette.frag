@@ -0,0 +1,14 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoord;
+// One palette index per cell
+uniform usampler2D cells;
+uniform vec4 palette[8];
+uniform int paletteSize;
+
+void main()
+{
+    uint index = texture(cells, TexCoord).r;
+    FragColor = palette[min(int(index), paletteSize - 1)];
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 TexCoord;
+in vec4 Tint;
+uniform sampler2D ourTexture;
+
+void main()
+{
+    FragColor = texture(ourTexture, TexCoord) * Tint;
+}
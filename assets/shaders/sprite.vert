@@ -0,0 +1,25 @@
+#version 330 core
+
+// Unit quad corner, and how far along the uv rect it lies
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aTexCoord;
+// Per instance
+layout(location = 2) in vec2 iPosition;
+layout(location = 3) in vec2 iSize;
+layout(location = 4) in vec4 iUvRect;
+layout(location = 5) in float iLayer;
+layout(location = 6) in vec4 iTint;
+
+out vec2 TexCoord;
+out vec4 Tint;
+
+// Layers that map to distinct depths, higher layers are nearer
+const float Layers = 256.0;
+
+void main()
+{
+    float depth = 1.0 - 2.0 * (iLayer + 0.5) / Layers;
+    gl_Position = vec4(iPosition + aPos * iSize, depth, 1.0);
+    TexCoord = mix(iUvRect.xy, iUvRect.zw, aTexCoord);
+    Tint = iTint;
+}
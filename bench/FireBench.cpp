@@ -0,0 +1,750 @@
+// Headless fire automaton benchmark. Runs every combination of the given grid
+// sizes, densities, thread counts and kernels for a number of generations and
+// prints one JSON object per run:
+//
+//   sar_bench_fire --size 1024x1024,4096x4096 --density 0.001,0.05
+//                  --threads 1,8 --kernel all --mode tiled --generations 100
+//
+// With --verify it instead runs the golden-state regression check described
+// at verifyKernels below and exits non-zero on any mismatch.
+//
+// Bandwidth counts the words the dense step streams each generation (front
+// grid read, back grid written, plus the flammability bytes with --forest), so
+// it is an estimate of the traffic, not a measurement.
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine/core/Random.hpp"
+#include "engine/core/WorkerPool.hpp"
+#include "engine/simulation/FireBrush.hpp"
+#include "engine/simulation/FireDirtyRects.hpp"
+#include "engine/simulation/FireHistory.hpp"
+#include "engine/simulation/FireKernels.hpp"
+#include "engine/simulation/FireSimulation.hpp"
+#include "engine/simulation/ForestCells.hpp"
+
+struct GridSize {
+    int width;
+    int height;
+};
+
+struct BenchOptions {
+    std::vector<GridSize> sizes = {{1024, 1024}};
+    std::vector<double> densities = {0.001};
+    std::vector<int> threads = {1};
+    std::vector<FireKernel> kernels = {FireKernel::Scalar};
+    FireStepMode mode = FireStepMode::Tiled;
+    int generations = 100;
+    uint64_t seed = 1;
+    bool forest = false;
+    bool sleeping = true;
+    bool verify = false;
+};
+
+
+static const FireKernel allKernels[] = {FireKernel::Reference, FireKernel::Scalar};
+
+static const char *modeName(FireStepMode mode) {
+    switch(mode) {
+    case FireStepMode::Dense:
+        return "dense";
+    case FireStepMode::Frontier:
+        return "frontier";
+    case FireStepMode::Tiled:
+        return "tiled";
+    case FireStepMode::Event:
+        return "event";
+    }
+    return "unknown";
+}
+
+static std::vector<std::string> splitList(const char *list) {
+    std::vector<std::string> items;
+    std::string item;
+    for(const char *c = list;; ++c) {
+        if(*c == ',' || *c == '\0') {
+            if(!item.empty())
+                items.push_back(item);
+            item.clear();
+            if(*c == '\0')
+                break;
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: sar_bench_fire [options]\n"
+                 "  --size WxH[,WxH...]      grid sizes (1024x1024)\n"
+                 "  --density D[,D...]       fraction of cells burning at the start (0.001)\n"
+                 "  --threads N[,N...]       worker threads, tiled mode only (1)\n"
+                 "  --kernel K[,K...]|all    reference or scalar (scalar)\n"
+                 "  --mode M                 dense, frontier, tiled or event (tiled)\n"
+                 "  --generations N          generations per run (100)\n"
+                 "  --seed S                 simulation and map seed (1)\n"
+                 "  --forest                 vary flammability with the forest model\n"
+                 "  --no-sleep               step every chunk every generation\n"
+                 "  --verify                 check every mode and kernel against the golden digests\n");
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options) {
+    for(int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if(!std::strcmp(arg, "--forest")) {
+            options.forest = true;
+            continue;
+        }
+        if(!std::strcmp(arg, "--no-sleep")) {
+            options.sleeping = false;
+            continue;
+        }
+        if(!std::strcmp(arg, "--verify")) {
+            options.verify = true;
+            continue;
+        }
+        if(!value) {
+            usage();
+            return false;
+        }
+        ++i;
+
+        if(!std::strcmp(arg, "--size")) {
+            options.sizes.clear();
+            for(const std::string &item: splitList(value)) {
+                GridSize size{};
+                if(std::sscanf(item.c_str(), "%dx%d", &size.width, &size.height) != 2 || size.width <= 0 || size.height <= 0) {
+                    std::fprintf(stderr, "Invalid grid size '%s'\n", item.c_str());
+                    return false;
+                }
+                options.sizes.push_back(size);
+            }
+        } else if(!std::strcmp(arg, "--density")) {
+            options.densities.clear();
+            for(const std::string &item: splitList(value))
+                options.densities.push_back(std::atof(item.c_str()));
+        } else if(!std::strcmp(arg, "--threads")) {
+            options.threads.clear();
+            for(const std::string &item: splitList(value))
+                options.threads.push_back(std::atoi(item.c_str()));
+        } else if(!std::strcmp(arg, "--kernel")) {
+            options.kernels.clear();
+            for(const std::string &item: splitList(value)) {
+                bool found = false;
+                for(FireKernel kernel: allKernels) {
+                    if(item == "all" || item == fireKernelName(kernel)) {
+                        options.kernels.push_back(kernel);
+                        found = true;
+                    }
+                }
+                if(!found) {
+                    std::fprintf(stderr, "Unknown kernel '%s'\n", item.c_str());
+                    return false;
+                }
+            }
+        } else if(!std::strcmp(arg, "--mode")) {
+            bool found = false;
+            for(FireStepMode mode: {FireStepMode::Dense, FireStepMode::Frontier, FireStepMode::Tiled, FireStepMode::Event}) {
+                if(!std::strcmp(value, modeName(mode))) {
+                    options.mode = mode;
+                    found = true;
+                }
+            }
+            if(!found) {
+                std::fprintf(stderr, "Unknown mode '%s'\n", value);
+                return false;
+            }
+        } else if(!std::strcmp(arg, "--generations")) {
+            options.generations = std::atoi(value);
+        } else if(!std::strcmp(arg, "--seed")) {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else {
+            usage();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Ignites each cell with probability density, drawn from the seed so every
+// run of a configuration starts from the same map
+static void seedFires(FireSimulation &fire, uint64_t seed, double density) {
+    CounterRng rng = CounterRng(seed).derive(1);
+    const int width = fire.grid().width();
+    const uint64_t cellCount = static_cast<uint64_t>(width) * fire.grid().height();
+    for(uint64_t cell = 0; cell < cellCount; ++cell) {
+        if(rng.uniform(cell) < density)
+            fire.ignite(static_cast<int>(cell % width), static_cast<int>(cell / width));
+    }
+}
+
+static uint64_t gridDigest(const FireGrid &grid) {
+    uint64_t digest = 0;
+    for(size_t i = 0; i < grid.wordCount(); ++i)
+        digest = CounterRng::mix64(digest ^ grid.words()[i]);
+    return digest;
+}
+
+static void runBench(const BenchOptions &options, GridSize size, double density, int threads, FireKernel kernel, bool &first) {
+    std::unique_ptr<ForestCells> forest;
+    std::unique_ptr<WorkerPool> workers;
+
+    FireSimulation fire(size.width, size.height);
+    fire.setSeed(options.seed);
+    fire.setKernel(kernel);
+    fire.setSleepingChunks(options.sleeping);
+    if(options.mode == FireStepMode::Tiled && threads != 1) {
+        workers = std::make_unique<WorkerPool>(threads);
+        fire.setWorkerPool(workers.get());
+    }
+    fire.setMode(options.mode);
+    if(options.forest) {
+        forest = std::make_unique<ForestCells>(size.width, size.height);
+        forest->generate(static_cast<unsigned int>(options.seed));
+        fire.setForest(forest.get());
+    }
+    seedFires(fire, options.seed, density);
+
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    for(int generation = 0; generation < options.generations; ++generation) {
+        if(options.mode == FireStepMode::Event)
+            fire.advance(1.0);
+        else
+            fire.step();
+    }
+    const double seconds = duration<double>(steady_clock::now() - start).count();
+
+    const double cellSteps = static_cast<double>(size.width) * size.height * options.generations;
+    double bytesPerGeneration = 2.0 * fire.grid().wordCount() * sizeof(uint64_t);
+    if(options.forest)
+        bytesPerGeneration += static_cast<double>(forest->stride()) * size.height;
+
+    const FireStatistics &stats = fire.statistics();
+    std::printf("%s  {\"mode\": \"%s\", \"kernel\": \"%s\", \"width\": %d, \"height\": %d, \"density\": %g, \"threads\": %d, "
+                "\"forest\": %s, \"generations\": %d, \"seconds\": %.6f, \"cells_per_second\": %.6g, \"ns_per_cell\": %.6g, "
+                "\"bandwidth_gb_per_second\": %.6g, \"burning\": %zu, \"burned\": %zu, \"digest\": \"%016llx\"}",
+                first ? "" : ",\n", modeName(options.mode), fireKernelName(fire.kernel()), size.width, size.height, density,
+                workers ? workers->threadCount() : 1, options.forest ? "true" : "false", options.generations, seconds,
+                cellSteps / seconds, seconds * 1e9 / cellSteps, bytesPerGeneration * options.generations / seconds / 1e9,
+                stats.burningCount(), stats.burnedArea(), static_cast<unsigned long long>(gridDigest(fire.grid())));
+    std::fflush(stdout);
+    first = false;
+}
+
+// Fixed maps stepped for a fixed number of generations. Their final grid
+// digests were recorded from the reference kernel in dense mode; a change to
+// the rules or the random streams changes them and has to update this table.
+struct VerifyScenario {
+    const char *name;
+    GridSize size;
+    double density;
+    bool forest;
+    // Wind towards windDegrees counter-clockwise from east, windStrength in [0, 1]
+    float windDegrees;
+    float windStrength;
+    int generations;
+    uint64_t golden;
+};
+
+static const VerifyScenario verifyScenarios[] = {
+    {"uniform", {300, 200}, 0.002, false, 0.0f, 0.0f, 64, 0xc3d3ff12806a46ccull},
+    {"forest", {517, 333}, 0.001, true, 0.0f, 0.0f, 96, 0x549fa9dce82b42ecull},
+    {"forest-wind", {640, 384}, 0.0005, true, 30.0f, 0.8f, 128, 0xdf024d07b6f7039bull},
+    {"sparse", {2048, 1024}, 0.00001, true, 200.0f, 0.5f, 64, 0x611ccc0dfcbd4971ull},
+};
+
+// Way of stepping checked against the reference run
+struct VerifyVariant {
+    FireStepMode mode;
+    FireKernel kernel;
+    int threads;
+    bool sleeping;
+};
+
+static void setupScenario(FireSimulation &fire, const VerifyScenario &scenario, const ForestCells *forest) {
+    fire.setSeed(0x5eed);
+    if(forest)
+        fire.setForest(forest);
+    fire.wind().setUniform(scenario.windDegrees * 3.14159265f / 180.0f, scenario.windStrength);
+    seedFires(fire, 0x5eed, scenario.density);
+}
+
+// Index of the first cell that differs, or -1 when the grids match
+static long long firstDifference(const FireGrid &a, const FireGrid &b) {
+    for(int y = 0; y < a.height(); ++y) {
+        for(int w = 0; w < a.wordsPerRow(); ++w) {
+            uint64_t diff = a.row(y)[w] ^ b.row(y)[w];
+            if(diff)
+                return static_cast<long long>(y) * a.width() + w * 64 + std::countr_zero(diff);
+        }
+    }
+    return -1;
+}
+
+// Burning cells, burned cells and perimeter edges counted from scratch
+struct FireCounts {
+    uint64_t burning = 0;
+    uint64_t burned = 0;
+    uint64_t perimeter = 0;
+};
+
+static FireCounts countFire(const FireSimulation &fire) {
+    const FireGrid &grid = fire.grid();
+    FireCounts counts;
+    counts.burning = grid.burningCount();
+    counts.burned = fire.burned().burningCount();
+    const int lastWord = grid.wordsPerRow() - 1;
+    for(int y = 0; y < grid.height(); ++y) {
+        const uint64_t *row = grid.row(y);
+        for(int w = 0; w <= lastWord; ++w) {
+            // Edges to the right neighbour, none past the last cell of the row
+            uint64_t right = row[w] >> 1;
+            if(w < lastWord)
+                right |= row[w + 1] << 63;
+            const uint64_t edges = w < lastWord ? ~uint64_t(0) : grid.lastWordMask() >> 1;
+            counts.perimeter += std::popcount((row[w] ^ right) & edges);
+            if(y + 1 < grid.height())
+                counts.perimeter += std::popcount(row[w] ^ grid.row(y + 1)[w]);
+        }
+    }
+    return counts;
+}
+
+// Compares the incrementally kept statistics with a full recount and checks
+// that every burning cell is also marked burned
+static bool statisticsMatch(const FireSimulation &fire, const char *scenario, const char *variant, int generation) {
+    const FireCounts counts = countFire(fire);
+    const FireStatistics &statistics = fire.statistics();
+    if(statistics.burningCount() != counts.burning || statistics.burnedArea() != counts.burned ||
+       statistics.perimeter() != counts.perimeter) {
+        std::printf("FAIL %s: %s statistics at generation %d are %llu/%llu/%llu burning/burned/perimeter, recount %llu/%llu/%llu\n",
+                    scenario, variant, generation, static_cast<unsigned long long>(statistics.burningCount()),
+                    static_cast<unsigned long long>(statistics.burnedArea()), static_cast<unsigned long long>(statistics.perimeter()),
+                    static_cast<unsigned long long>(counts.burning), static_cast<unsigned long long>(counts.burned),
+                    static_cast<unsigned long long>(counts.perimeter));
+        return false;
+    }
+    const FireGrid &grid = fire.grid();
+    for(size_t i = 0; i < grid.wordCount(); ++i) {
+        if(grid.words()[i] & ~fire.burned().words()[i]) {
+            std::printf("FAIL %s: %s has burning cells not marked burned at generation %d\n", scenario, variant, generation);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Random square and circle stamps, some of them hanging over the grid edges
+static void randomStamps(FireStampBatch &stamps, std::vector<FireBrush> &brushes, const CounterRng &rng, GridSize size) {
+    stamps.clear();
+    brushes.clear();
+    for(uint64_t i = 0; i < 16; ++i) {
+        const BrushShape shape = rng.u64(i * 5) & 1 ? BrushShape::Circle : BrushShape::Square;
+        const int radiusX = static_cast<int>(rng.u64(i * 5 + 1) % 24);
+        const int radiusY = static_cast<int>(rng.u64(i * 5 + 2) % 24);
+        const int x = static_cast<int>(rng.u64(i * 5 + 3) % (size.width + 32)) - 16;
+        const int y = static_cast<int>(rng.u64(i * 5 + 4) % (size.height + 32)) - 16;
+        brushes.emplace_back(shape, radiusX, radiusY);
+        stamps.add(x, y, brushes.back());
+    }
+}
+
+// Stamping cross-check. Two copies of every scenario are stepped side by side
+// and random brush stamps are put out each generation, once through
+// extinguishStamps and once cell by cell through extinguish. In the modes that
+// follow the generation rolls both grids, the burned grids and the statistics
+// must stay equal. In event mode the cells relit depend on the order cells are
+// put out, so only the statistics of each copy are checked against a recount.
+static bool verifyStamping(const VerifyScenario &scenario, const ForestCells *forest, WorkerPool &workers) {
+    static const VerifyVariant stampVariants[] = {
+        {FireStepMode::Dense, FireKernel::Scalar, 1, true},
+        {FireStepMode::Tiled, FireKernel::Scalar, 4, true},
+        {FireStepMode::Frontier, FireKernel::Scalar, 1, true},
+        {FireStepMode::Event, FireKernel::Scalar, 1, true},
+    };
+    const CounterRng rng = CounterRng(0x5eed).derive(2);
+    FireStampBatch stamps;
+    std::vector<FireBrush> brushes;
+    for(const VerifyVariant &variant: stampVariants) {
+        FireSimulation batched(scenario.size.width, scenario.size.height);
+        FireSimulation perCell(scenario.size.width, scenario.size.height);
+        for(FireSimulation *fire: {&batched, &perCell}) {
+            fire->setKernel(variant.kernel);
+            fire->setWorkerPool(variant.threads > 1 ? &workers : nullptr);
+            fire->setMode(variant.mode);
+            setupScenario(*fire, scenario, forest);
+        }
+
+        const bool event = variant.mode == FireStepMode::Event;
+        for(int generation = 1; generation <= scenario.generations; ++generation) {
+            if(event) {
+                batched.advance(1.0);
+                perCell.advance(1.0);
+            } else {
+                batched.step();
+                perCell.step();
+            }
+            randomStamps(stamps, brushes, rng.derive(generation), scenario.size);
+            batched.extinguishStamps(stamps);
+            for(const FireStampBatch::Span &span: stamps.spans()) {
+                if(span.y < 0 || span.y >= scenario.size.height)
+                    continue;
+                for(int x = std::max(span.x0, 0); x < std::min(span.x1, scenario.size.width); ++x)
+                    perCell.extinguish(x, span.y);
+            }
+
+            if(!statisticsMatch(batched, scenario.name, "stamped", generation) ||
+               !statisticsMatch(perCell, scenario.name, "per-cell extinguished", generation))
+                return false;
+            if(event)
+                continue;
+            long long cell = firstDifference(perCell.grid(), batched.grid());
+            if(cell < 0)
+                cell = firstDifference(perCell.burned(), batched.burned());
+            if(cell >= 0) {
+                std::printf("FAIL %s: %s stamping differs from per-cell extinguish at generation %d, first cell (%lld, %lld)\n",
+                            scenario.name, modeName(variant.mode), generation, cell % scenario.size.width,
+                            cell / scenario.size.width);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Time-sliced stepping cross-check. One copy of every scenario steps each
+// generation in slices of varying size, with random ignitions and brush stamps
+// sent while the step is in progress; the other steps in full and gets the
+// same edits right after. The edits must not touch the grid mid-step, and
+// both copies must match cell for cell after every generation.
+static bool verifySlicing(const VerifyScenario &scenario, const ForestCells *forest, WorkerPool &workers) {
+    static const VerifyVariant sliceVariants[] = {
+        {FireStepMode::Dense, FireKernel::Scalar, 1, true},
+        {FireStepMode::Tiled, FireKernel::Scalar, 4, true},
+    };
+    static const float fractions[] = {0.1f, 0.37f, 0.5f, 1.0f};
+    const CounterRng rng = CounterRng(0x5eed).derive(3);
+    FireStampBatch stamps;
+    std::vector<FireBrush> brushes;
+    FireGrid before;
+    for(const VerifyVariant &variant: sliceVariants) {
+        FireSimulation sliced(scenario.size.width, scenario.size.height);
+        FireSimulation full(scenario.size.width, scenario.size.height);
+        for(FireSimulation *fire: {&sliced, &full}) {
+            fire->setKernel(variant.kernel);
+            fire->setWorkerPool(variant.threads > 1 ? &workers : nullptr);
+            fire->setMode(variant.mode);
+            setupScenario(*fire, scenario, forest);
+        }
+
+        for(int generation = 1; generation <= scenario.generations; ++generation) {
+            const CounterRng generationRng = rng.derive(generation);
+            const float fraction = fractions[generation % std::size(fractions)];
+            randomStamps(stamps, brushes, generationRng, scenario.size);
+            const int igniteX = static_cast<int>(generationRng.u64(100) % scenario.size.width);
+            const int igniteY = static_cast<int>(generationRng.u64(101) % scenario.size.height);
+
+            sliced.beginStep();
+            bool done = sliced.continueStep(fraction);
+            // A step done in a single slice leaves no time to edit in between
+            const bool deferred = !done;
+            if(deferred) {
+                before = sliced.grid();
+                sliced.ignite(igniteX, igniteY);
+                sliced.extinguishStamps(stamps);
+                if(firstDifference(before, sliced.grid()) >= 0) {
+                    std::printf("FAIL %s: %s edits changed the grid during a sliced step at generation %d\n", scenario.name,
+                                modeName(variant.mode), generation);
+                    return false;
+                }
+            }
+            while(!done)
+                done = sliced.continueStep(fraction);
+
+            if(!deferred) {
+                sliced.ignite(igniteX, igniteY);
+                sliced.extinguishStamps(stamps);
+            }
+            full.step();
+            full.ignite(igniteX, igniteY);
+            full.extinguishStamps(stamps);
+
+            if(!statisticsMatch(sliced, scenario.name, "sliced", generation))
+                return false;
+            long long cell = firstDifference(full.grid(), sliced.grid());
+            if(cell < 0)
+                cell = firstDifference(full.burned(), sliced.burned());
+            if(cell >= 0) {
+                std::printf("FAIL %s: %s sliced step differs from a full step at generation %d, first cell (%lld, %lld)\n",
+                            scenario.name, modeName(variant.mode), generation, cell % scenario.size.width,
+                            cell / scenario.size.width);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// History round trip. The reference generations are recorded into a ring
+// shorter than the run, skipping every fifth one, with a keyframe interval
+// that does not divide the ring. After every record the oldest, the newest and
+// one kept generation in between must restore to the reference grids; at the
+// end every kept generation is restored and dropped or skipped ones must not be.
+static bool verifyHistory(const VerifyScenario &scenario, const std::vector<FireGrid> &history) {
+    const size_t capacity = history.size() / 3 + 2;
+    FireHistory ring(capacity, 7);
+    FireGrid restored;
+    auto restoresTo = [&](uint64_t generation) {
+        if(!ring.restore(generation, restored)) {
+            std::printf("FAIL %s: history lost generation %llu, keeping %llu to %llu\n", scenario.name,
+                        static_cast<unsigned long long>(generation), static_cast<unsigned long long>(ring.oldestGeneration()),
+                        static_cast<unsigned long long>(ring.newestGeneration()));
+            return false;
+        }
+        const long long cell = firstDifference(history[generation], restored);
+        if(cell >= 0) {
+            std::printf("FAIL %s: history restores generation %llu wrong, first cell (%lld, %lld)\n", scenario.name,
+                        static_cast<unsigned long long>(generation), cell % scenario.size.width, cell / scenario.size.width);
+            return false;
+        }
+        return true;
+    };
+
+    for(uint64_t generation = 0; generation < history.size(); ++generation) {
+        if(generation % 5 == 4)
+            continue;
+        ring.record(history[generation], generation);
+        const uint64_t oldest = ring.oldestGeneration();
+        uint64_t middle = oldest + (generation - oldest) / 2;
+        if(middle % 5 == 4)
+            --middle;
+        if(!restoresTo(oldest) || !restoresTo(middle) || !restoresTo(generation))
+            return false;
+    }
+
+    if(ring.size() != capacity) {
+        std::printf("FAIL %s: history keeps %zu generations, capacity %zu\n", scenario.name, ring.size(), capacity);
+        return false;
+    }
+    for(uint64_t generation = 0; generation < history.size(); ++generation) {
+        const bool kept = generation >= ring.oldestGeneration() && generation % 5 != 4;
+        if(kept ? !restoresTo(generation) : ring.restore(generation, restored)) {
+            if(!kept)
+                std::printf("FAIL %s: history restores generation %llu it should not keep\n", scenario.name,
+                            static_cast<unsigned long long>(generation));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Dirty rectangle coverage. The reference generations are fed to a
+// FireDirtyRects with three targets, like the slices of a streaming buffer,
+// alternating between whole-grid updates and updates of only the chunks that
+// changed. Each generation one target copies the cells of its rects into its
+// own grid and is cleared; that grid must then equal the reference. Halfway
+// through, markAll has to make the rects of every target cover the whole grid.
+static bool verifyDirtyRects(const VerifyScenario &scenario, const std::vector<FireGrid> &history) {
+    static const int targets = 3;
+    const int tile = FireSimulation::TileSize;
+    FireDirtyRects dirtyRects;
+    dirtyRects.setTargets(targets);
+    std::vector<FireGrid> drawn(targets);
+    for(FireGrid &grid: drawn)
+        grid.resize(scenario.size.width, scenario.size.height);
+
+    for(size_t generation = 0; generation < history.size(); ++generation) {
+        const FireGrid &grid = history[generation];
+        if(generation % 2 == 0) {
+            dirtyRects.update(grid);
+        } else {
+            for(int chunkY = 0; chunkY * tile < grid.height(); ++chunkY) {
+                for(int w = 0; w < grid.wordsPerRow(); ++w) {
+                    bool changed = false;
+                    for(int y = chunkY * tile; y < std::min((chunkY + 1) * tile, grid.height()); ++y)
+                        changed |= grid.row(y)[w] != history[generation - 1].row(y)[w];
+                    if(changed)
+                        dirtyRects.update(grid, Rect{w * 64, chunkY * tile, 64, tile});
+                }
+            }
+        }
+        if(generation == history.size() / 2)
+            dirtyRects.markAll();
+
+        const int target = static_cast<int>(generation % targets);
+        long long area = 0;
+        for(const Rect &rect: dirtyRects.rects(target)) {
+            if(rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 || rect.x + rect.width > grid.width() ||
+               rect.y + rect.height > grid.height()) {
+                std::printf("FAIL %s: dirty rect (%d, %d) %dx%d at generation %zu is outside the grid\n", scenario.name, rect.x,
+                            rect.y, rect.width, rect.height, generation);
+                return false;
+            }
+            area += static_cast<long long>(rect.width) * rect.height;
+            for(int y = rect.y; y < rect.y + rect.height; ++y) {
+                for(int x = rect.x; x < rect.x + rect.width; ++x) {
+                    if(grid.isBurning(x, y))
+                        drawn[target].ignite(x, y);
+                    else
+                        drawn[target].extinguish(x, y);
+                }
+            }
+        }
+        dirtyRects.clear(target);
+
+        if(generation == history.size() / 2 && area != static_cast<long long>(grid.width()) * grid.height()) {
+            std::printf("FAIL %s: dirty rects cover %lld cells after markAll, the grid has %lld\n", scenario.name, area,
+                        static_cast<long long>(grid.width()) * grid.height());
+            return false;
+        }
+        if(!dirtyRects.empty(target)) {
+            std::printf("FAIL %s: dirty rects of target %d are not empty after clear\n", scenario.name, target);
+            return false;
+        }
+        const long long cell = firstDifference(grid, drawn[target]);
+        if(cell >= 0) {
+            std::printf("FAIL %s: dirty rects of target %d miss a change at generation %zu, first cell (%lld, %lld)\n",
+                        scenario.name, target, generation, cell % scenario.size.width, cell / scenario.size.width);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Golden-state regression check. Every scenario is stepped once by the
+// reference kernel in dense mode, whose final digest must match the golden
+// table, and once per variant in lockstep with it: every mode that follows
+// the generation rolls (dense with and without sleeping chunks, tiled on one
+// and several threads, frontier) with both kernels. The first
+// generation and cell where a variant leaves the reference is reported. The
+// event mode draws different random paths by design and is not compared.
+//
+// After every generation of every variant, and of an event mode run, the
+// statistics are also recounted from the grids, verifyStamping checks the
+// batched brush stamps against per-cell extinguish, verifySlicing checks
+// time-sliced steps with deferred edits against full ones, verifyHistory
+// restores the reference generations from a FireHistory ring and
+// verifyDirtyRects checks that dirty rects cover every change.
+static bool verifyKernels() {
+    std::vector<VerifyVariant> variants;
+    for(FireKernel kernel: allKernels) {
+        variants.push_back({FireStepMode::Dense, kernel, 1, true});
+        variants.push_back({FireStepMode::Dense, kernel, 1, false});
+        variants.push_back({FireStepMode::Tiled, kernel, 1, true});
+        variants.push_back({FireStepMode::Tiled, kernel, 4, true});
+    }
+    variants.push_back({FireStepMode::Frontier, FireKernel::Scalar, 1, true});
+
+    WorkerPool workers(4);
+    bool passed = true;
+    for(const VerifyScenario &scenario: verifyScenarios) {
+        std::unique_ptr<ForestCells> forest;
+        if(scenario.forest) {
+            forest = std::make_unique<ForestCells>(scenario.size.width, scenario.size.height);
+            forest->generate(0x5eed);
+        }
+        bool scenarioPassed = true;
+
+        FireSimulation reference(scenario.size.width, scenario.size.height);
+        reference.setKernel(FireKernel::Reference);
+        reference.setMode(FireStepMode::Dense);
+        reference.setSleepingChunks(false);
+        setupScenario(reference, scenario, forest.get());
+        std::vector<FireGrid> history = {reference.grid()};
+        for(int generation = 0; generation < scenario.generations; ++generation) {
+            reference.step();
+            history.push_back(reference.grid());
+        }
+
+        const uint64_t digest = gridDigest(reference.grid());
+        if(digest != scenario.golden) {
+            std::printf("FAIL %s: reference digest %016llx, golden %016llx\n", scenario.name,
+                        static_cast<unsigned long long>(digest), static_cast<unsigned long long>(scenario.golden));
+            scenarioPassed = false;
+        }
+
+        for(const VerifyVariant &variant: variants) {
+            FireSimulation fire(scenario.size.width, scenario.size.height);
+            fire.setKernel(variant.kernel);
+            fire.setSleepingChunks(variant.sleeping);
+            fire.setWorkerPool(variant.threads > 1 ? &workers : nullptr);
+            fire.setMode(variant.mode);
+            setupScenario(fire, scenario, forest.get());
+
+            const char *sleepName = variant.sleeping ? "sleep" : "nosleep";
+            for(int generation = 0; generation <= scenario.generations; ++generation) {
+                if(generation > 0)
+                    fire.step();
+                long long cell = firstDifference(history[generation], fire.grid());
+                if(cell >= 0) {
+                    std::printf("FAIL %s: %s/%s/%d threads/%s differs at generation %d, first cell (%lld, %lld)\n",
+                                scenario.name, modeName(variant.mode), fireKernelName(variant.kernel), variant.threads,
+                                sleepName, generation, cell % scenario.size.width, cell / scenario.size.width);
+                    scenarioPassed = false;
+                    break;
+                }
+                if(!statisticsMatch(fire, scenario.name, modeName(variant.mode), generation)) {
+                    scenarioPassed = false;
+                    break;
+                }
+            }
+        }
+
+        FireSimulation event(scenario.size.width, scenario.size.height);
+        event.setMode(FireStepMode::Event);
+        setupScenario(event, scenario, forest.get());
+        for(int generation = 0; generation <= scenario.generations; ++generation) {
+            if(generation > 0)
+                event.advance(1.0);
+            if(!statisticsMatch(event, scenario.name, modeName(FireStepMode::Event), generation)) {
+                scenarioPassed = false;
+                break;
+            }
+        }
+        scenarioPassed &= verifyStamping(scenario, forest.get(), workers);
+        scenarioPassed &= verifySlicing(scenario, forest.get(), workers);
+        scenarioPassed &= verifyHistory(scenario, history);
+        scenarioPassed &= verifyDirtyRects(scenario, history);
+
+        passed &= scenarioPassed;
+        std::printf("%s %s: %dx%d, %d generations, %zu variants, digest %016llx\n", scenarioPassed ? "ok" : "--", scenario.name,
+                    scenario.size.width, scenario.size.height, scenario.generations, variants.size(),
+                    static_cast<unsigned long long>(digest));
+    }
+    std::printf(passed ? "All fire variants match\n" : "Fire variants differ\n");
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if(!parseOptions(argc, argv, options))
+        return 1;
+    if(options.verify)
+        return verifyKernels() ? 0 : 1;
+    bool first = true;
+    std::printf("[\n");
+    for(GridSize size: options.sizes) {
+        for(double density: options.densities) {
+            for(int threads: options.threads) {
+                for(FireKernel kernel: options.kernels)
+                    runBench(options, size, density, threads, kernel, first);
+            }
+        }
+    }
+    std::printf("\n]\n");
+    return 0;
+}
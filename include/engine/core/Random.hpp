@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Stateless counter-based random numbers. A CounterRng is only a 64-bit key;
+// every draw is a pure function of (key, counter), so threads and SIMD lanes
+// can draw in any order without sharing state and the same seed always gives
+// the same numbers. Independent streams are derived from a key, e.g.
+// rng.derive(Stream).derive(tick), and indexed by cell or entity.
+class CounterRng {
+private:
+    uint64_t _key;
+
+public:
+    explicit CounterRng(uint64_t seed = 0) : _key(mix64(seed)) {}
+
+    // SplitMix64 finalizer
+    static uint64_t mix64(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // 32-bit integer hash, used where only 32-bit multiplies are available (SIMD lanes)
+    static uint32_t hash32(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    uint64_t key() const { return _key; }
+    CounterRng derive(uint64_t stream) const;
+
+    uint64_t u64(uint64_t counter) const { return mix64(_key + counter * 0x9e3779b97f4a7c15ull); }
+    uint32_t u32(uint64_t counter) const { return static_cast<uint32_t>(u64(counter) >> 32); }
+    // Uniform in [0, 1)
+    float uniform(uint64_t counter) const { return static_cast<float>(u64(counter) >> 40) * 0x1.0p-24f; }
+    // Uniform integer in [min, max)
+    int range(uint64_t counter, int min, int max) const;
+
+    // 32-bit lane stream: hash32(counter ^ key32) for counters that fit in 32 bits.
+    // This is the form the vectorised fire kernels evaluate per lane.
+    uint32_t key32() const { return static_cast<uint32_t>(_key); }
+    uint32_t lane32(uint32_t counter) const { return hash32(counter ^ key32()); }
+
+    // Bulk draws of counters [firstCounter, firstCounter + count)
+    void fillU32(uint64_t firstCounter, uint32_t *out, size_t count) const;
+    void fillUniform(uint64_t firstCounter, float *out, size_t count) const;
+    void fillLane32(uint32_t firstCounter, uint32_t *out, size_t count) const;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// Axis-aligned rectangle in whole cells or pixels
+struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
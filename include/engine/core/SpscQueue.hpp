@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// push fails instead of blocking when the queue is full.
+template<typename T>
+class SpscQueue {
+private:
+    std::vector<T> _items;
+    size_t _mask;
+    // Free-running counters, the slot of a counter is counter & _mask. Each is
+    // written by one side only and kept on its own cache line.
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : _items(std::bit_ceil(capacity < 2 ? size_t(2) : capacity)), _mask(_items.size() - 1), _head(0), _tail(0) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    size_t capacity() const { return _items.size(); }
+
+    // Producer side
+    bool push(const T &item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head.load(std::memory_order_acquire) == _items.size())
+            return false;
+        _items[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _tail.load(std::memory_order_acquire))
+            return false;
+        item = _items[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
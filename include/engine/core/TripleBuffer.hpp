@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of whole values from one writer thread to one reader
+// thread. The writer fills back() and publishes it, the reader swaps in the
+// newest published value with acquire(); neither side ever waits. Each side
+// owns one slot and the third holds the latest published value between them,
+// so values the reader never picked up are simply overwritten.
+template<typename T>
+class TripleBuffer {
+private:
+    // Set in _middle while its slot holds a value the reader has not taken yet
+    static constexpr uint8_t FreshBit = 4;
+    static constexpr uint8_t SlotMask = 3;
+
+    T _slots[3];
+    int _writeSlot;
+    int _readSlot;
+    // Index of the shared slot plus FreshBit
+    std::atomic<uint8_t> _middle;
+
+public:
+    TripleBuffer() : _writeSlot(0), _readSlot(1), _middle(2) {}
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Writer side. The slot may hold any older value and has to be filled completely.
+    T &back() { return _slots[_writeSlot]; }
+    void publish() {
+        uint8_t previous = _middle.exchange(static_cast<uint8_t>(_writeSlot | FreshBit), std::memory_order_acq_rel);
+        _writeSlot = previous & SlotMask;
+    }
+
+    // Reader side. Returns false and keeps front() when nothing was published
+    // since the last call.
+    bool acquire() {
+        if(!(_middle.load(std::memory_order_relaxed) & FreshBit))
+            return false;
+        uint8_t previous = _middle.exchange(static_cast<uint8_t>(_readSlot), std::memory_order_acq_rel);
+        _readSlot = previous & SlotMask;
+        return true;
+    }
+    const T &front() const { return _slots[_readSlot]; }
+};
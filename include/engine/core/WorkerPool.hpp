@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split an indexed job between themselves.
+// The calling thread takes part in every parallelFor, so a pool of N threads
+// only spawns N - 1 workers.
+class WorkerPool {
+private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+
+    const std::function<void(int)> *_job;
+    int _jobCount;
+    std::atomic<int> _nextIndex;
+    int _busyWorkers;
+    uint64_t _epoch;
+    bool _stopping;
+
+    void workerLoop();
+    void runJobs();
+
+public:
+    // threadCount <= 0 uses every hardware thread
+    explicit WorkerPool(int threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    int threadCount() const { return static_cast<int>(_threads.size()) + 1; }
+
+    // Calls job(i) for every i in [0, count) and returns once all calls finished
+    void parallelFor(int count, const std::function<void(int)> &job);
+};
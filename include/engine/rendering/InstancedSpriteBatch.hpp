@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "engine/rendering/SpriteBatch.hpp"
+#include "engine/rendering/StreamingBuffer.hpp"
+#include "engine/rendering/Texture.hpp"
+
+// Per sprite data of the instanced path, read by the sprite shader
+struct SpriteInstance {
+    // Centre in normalized device coordinates
+    float x;
+    float y;
+    float width;
+    float height;
+    UvRect uv;
+    float layer;
+    // RGBA bytes in memory order, multiplied with the texture colour
+    uint32_t tint;
+};
+
+// Sprite renderer that uploads one SpriteInstance per sprite and draws every
+// run of sprites with the same layer and texture with a single instanced draw
+// of the unit quad. Layers are drawn from low to high; within a layer sprites
+// are grouped by texture, so their order is only kept among sprites sharing a
+// texture.
+class InstancedSpriteBatch {
+public:
+    static constexpr int DefaultCapacity = 65536;
+    static constexpr uint32_t White = 0xffffffff;
+
+private:
+    // Submitted sprite, sorted by layer, texture and then submission order
+    struct Entry {
+        int layer;
+        GLuint texture;
+        uint32_t index;
+    };
+
+    GLuint _program;
+    // Unit quad vertex array owned by the caller, the instance attributes are added to it
+    GLuint _vertexArray;
+    StreamingBuffer _instances;
+    int _capacity;
+    std::vector<SpriteInstance> _pending;
+    std::vector<Entry> _entries;
+    size_t _drawCalls;
+
+    void bindInstances(size_t offset);
+    void draw(const Entry *entries, size_t count);
+
+public:
+    InstancedSpriteBatch();
+
+    // Needs a current GL context. unitQuad holds a quad from -0.5 to 0.5 in
+    // attribute 0 and its corner's place in the uv rect, from 0 to 1, in
+    // attribute 1. capacity is in sprites per buffer slice.
+    void create(GLuint unitQuad, int capacity = DefaultCapacity);
+    void discard();
+    void setProgram(GLuint program) { _program = program; }
+
+    void begin();
+    void submit(float x, float y, float width, float height, const Texture &texture, const UvRect &uv = UvRect(), int layer = 0,
+                uint32_t tint = White);
+    void end();
+
+    // Draw calls issued by the last end
+    size_t drawCalls() const { return _drawCalls; }
+};
@@ -8,15 +8,39 @@
 
 #include <GLFW/glfw3.h>
 
+#include "engine/core/Rect.hpp"
+#include "engine/rendering/InstancedSpriteBatch.hpp"
+#include "engine/rendering/SpriteBatch.hpp"
+#include "engine/rendering/StreamingBuffer.hpp"
 #include "engine/rendering/Texture.hpp"
 
 class RenderWindow {
 private:
     GLFWwindow *_window;
     GLuint _shaderProgram;
+    // Draws the background from palette indices instead of colours
+    GLuint _paletteProgram;
     GLuint _backgroundTexture;
-    int _width, _height;
-    GLuint _pbo;
+    bool _paletteBackground;
+    std::vector<float> _palette;
+    // Draws sprites with the main shader program
+    SpriteBatch _spriteBatch;
+    // Quad from -0.5 to 0.5 every instanced sprite is drawn from
+    GLuint _unitQuadArray;
+    GLuint _unitQuadVertices;
+    GLuint _unitQuadIndices;
+    GLuint _spriteProgram;
+    InstancedSpriteBatch _instancedSprites;
+
+    void createUnitQuad();
+    // Size of the background texture and of a PBO slice, in pixels
+    int _backgroundWidth, _backgroundHeight;
+    // Framebuffer width over height, refreshed by clear once per frame
+    float _aspectRatio;
+
+    void updateAspectRatio();
+    // Pixel unpack buffer the background is written to and uploaded from
+    StreamingBuffer _pbo;
 
 
     std::vector<GLuint> _loadedTextures;
@@ -36,6 +60,12 @@ public:
     int getKey(int key);
 
     void setShaderProgram(GLuint vertexShader, GLuint fragmentShader);
+    void setPaletteShaderProgram(GLuint vertexShader, GLuint fragmentShader);
+    // Program the instanced sprites are drawn with
+    void setSpriteShaderProgram(GLuint vertexShader, GLuint fragmentShader);
+    // RGBA colours of the palette indices 0 to count - 1, at most MaxPaletteSize
+    void setPalette(const float *rgba, int count);
+    static constexpr int MaxPaletteSize = 8;
 
     void clear();
     void render();
@@ -43,10 +73,27 @@ public:
     void loadTexture(struct Texture &texture);
     void drawTexture(float x, float y, float width, float height, struct Texture texture, bool cleanup = true);
     void drawTexture(float x, float y, float scale, struct Texture texture, bool cleanup = true);
+    // Width and height drawTexture uses for a sprite of the given scale in a
+    // framebuffer of the given aspect ratio
+    static std::pair<float, float> scaledSize(float scale, const struct Texture &texture, float aspectRatio);
+    float aspectRatio() const { return _aspectRatio; }
+    SpriteBatch &spriteBatch() { return _spriteBatch; }
+    // Only usable once a sprite shader program is set
+    InstancedSpriteBatch &instancedSprites() { return _instancedSprites; }
+    bool hasInstancedSprites() const { return _spriteProgram != 0; }
 
-    void createBackgroundTextureBuffer(int width, int height);
+    // A palette background holds one palette index byte per pixel in an R8UI
+    // texture, the default one RGBA colours
+    void createBackgroundTextureBuffer(int width, int height, bool palette = false);
+    bool paletteBackground() const { return _paletteBackground; }
+    // Slice of the PBO the next mapPBO writes to, each slice keeps its own
+    // contents between uses
+    int pboSlice() const { return _pbo.slice(); }
+    int pboSlices() const { return _pbo.slices(); }
     GLubyte *mapPBO();
     void unmapPBO();
     void updateTextureFromPBO();
+    // Uploads only the given pixel rectangles of the PBO
+    void updateTextureFromPBO(const std::vector<Rect> &rects);
     void drawBackground();
 };
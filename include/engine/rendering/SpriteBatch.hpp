@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "engine/rendering/StreamingBuffer.hpp"
+#include "engine/rendering/Texture.hpp"
+
+// Part of a texture a sprite shows, in texture coordinates
+struct UvRect {
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
+};
+
+// Layout expected by the main shader
+struct SpriteVertex {
+    float x;
+    float y;
+    float u;
+    float v;
+};
+
+// Collects sprites between begin and end into one streaming vertex buffer and
+// draws them with a static index buffer shared by every quad, one draw call
+// per run of sprites with the same texture. Sprites are drawn in the order
+// they were submitted, so sorting them by texture saves draw calls. A full
+// buffer is drawn and refilled in the middle of a frame.
+class SpriteBatch {
+public:
+    static constexpr int DefaultCapacity = 65536;
+
+private:
+    // Consecutive sprites sharing a texture
+    struct Run {
+        GLuint texture;
+        int first;
+        int count;
+    };
+
+    GLuint _program;
+    GLuint _vertexArray;
+    GLuint _indexBuffer;
+    StreamingBuffer _vertices;
+    int _capacity;
+    SpriteVertex *_mapped;
+    int _count;
+    std::vector<Run> _runs;
+    size_t _drawCalls;
+
+    void map();
+    void flush();
+
+public:
+    SpriteBatch();
+
+    // Needs a current GL context, capacity is in sprites per buffer slice
+    void create(int capacity = DefaultCapacity);
+    void discard();
+    void setProgram(GLuint program) { _program = program; }
+
+    void begin();
+    // Sprite centred on (x, y) in normalized device coordinates
+    void submit(float x, float y, float width, float height, const Texture &texture, const UvRect &uv = UvRect());
+    void end();
+
+    // Draw calls issued since the last begin
+    size_t drawCalls() const { return _drawCalls; }
+};
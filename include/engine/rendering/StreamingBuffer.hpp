@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/gl.h>
+
+// GPU buffer written by the CPU every frame. With GL 4.4 it is mapped once,
+// persistently and coherently, and split into Slices slices written in turn: a
+// fence placed after the commands reading a slice tells when it may be written
+// again, so mapping never waits for the upload that is still in flight.
+// Without GL 4.4 it is a single slice mapped and unmapped on every use, which
+// orphans the old contents unless they are kept.
+class StreamingBuffer {
+public:
+    static constexpr int Slices = 3;
+
+private:
+    GLenum _target;
+    GLuint _buffer;
+    size_t _sliceSize;
+    bool _persistent;
+    bool _keepContents;
+    int _current;
+    GLubyte *_mapped;
+    GLsync _fences[Slices];
+
+public:
+    StreamingBuffer();
+
+    // keepContents is for callers that rewrite only parts of a slice, every
+    // slice then still holds what was last written to it
+    void create(GLenum target, size_t sliceSize, bool keepContents = true);
+    void discard();
+
+    bool persistent() const { return _persistent; }
+    int slices() const { return _persistent ? Slices : 1; }
+    // Slice the next map returns
+    int slice() const { return _current; }
+
+    // Waits until the current slice is no longer read and returns it, null
+    // when the buffer could not be mapped
+    GLubyte *map();
+    void unmap();
+
+    GLuint id() const { return _buffer; }
+    // Byte offset of the current slice, passed as the pointer argument of GL
+    // calls reading from the bound buffer
+    size_t offset() const { return static_cast<size_t>(_current) * _sliceSize; }
+    // Call once the commands reading the current slice were issued, fences it
+    // and moves on to the next one
+    void advance();
+};
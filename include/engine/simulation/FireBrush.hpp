@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+enum class BrushShape {
+    Square,
+    Circle
+};
+
+// Precomputed stamp footprint, stored as the half width of every row from
+// -radiusY to radiusY so stamping works on whole spans instead of cells
+class FireBrush {
+private:
+    int _radiusX;
+    int _radiusY;
+    std::vector<int> _halfWidths;
+
+public:
+    FireBrush(BrushShape shape = BrushShape::Square, int radiusX = 0, int radiusY = 0);
+
+    int radiusX() const { return _radiusX; }
+    int radiusY() const { return _radiusY; }
+    // Cells [x - halfWidth, x + halfWidth] of row y + dy are covered
+    int halfWidth(int dy) const { return _halfWidths[dy + _radiusY]; }
+};
+
+// Brush stamps collected over a frame and merged into disjoint row spans, so
+// overlapping stamps clear every cell once
+class FireStampBatch {
+public:
+    // Cells [x0, x1) of row y
+    struct Span {
+        int y;
+        int x0;
+        int x1;
+    };
+
+private:
+    std::vector<Span> _spans;
+    bool _merged;
+
+public:
+    FireStampBatch() : _merged(true) {}
+
+    void clear();
+    void add(int x, int y, const FireBrush &brush);
+
+    bool empty() const { return _spans.empty(); }
+    // Sorted by row then column, overlapping and touching spans joined
+    const std::vector<Span> &spans();
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine/core/Rect.hpp"
+#include "engine/simulation/FireGrid.hpp"
+
+// Tracks which parts of a fire grid changed since it was last drawn. Grids are
+// compared word by word against a copy of the last one seen, so it works the
+// same for live, replayed and expanded coarse grids. Changes are kept per tile
+// of one word (64 cells) by TileHeight rows and handed out as a few merged
+// rectangles. Several targets holding a copy of the picture (such as the
+// slices of a streaming buffer) can each keep their own dirty tiles, a change
+// stays dirty for a target until that target was cleared.
+class FireDirtyRects {
+public:
+    static constexpr int TileWidth = 64;
+    static constexpr int TileHeight = 8;
+    // Dirty tiles at most this many clean tiles apart are joined, one larger
+    // upload is cheaper than several small ones
+    static constexpr int MergeGap = 1;
+    static constexpr int MaxTargets = 8;
+
+private:
+    FireGrid _shown;
+    int _tilesX;
+    int _tilesY;
+    // One bit per target for every tile
+    std::vector<uint8_t> _dirty;
+    uint8_t _targetMask;
+    // Targets with at least one dirty tile
+    uint8_t _anyDirty;
+    std::vector<Rect> _rects;
+
+public:
+    FireDirtyRects() : _tilesX(0), _tilesY(0), _targetMask(1), _anyDirty(0) {}
+
+    // Between 1 and MaxTargets, marks everything dirty
+    void setTargets(int count);
+    // Marks everything dirty for every target, as does a grid of a different size
+    void markAll();
+    // Marks the tiles where grid differs from the last grid passed in
+    void update(const FireGrid &grid);
+    // Same, comparing only the tiles that overlap region. The rest of grid
+    // has to match the last grid passed in already.
+    void update(const FireGrid &grid, const Rect &region);
+    // Forgets the dirty tiles of target once they were drawn into it
+    void clear(int target = 0);
+
+    bool empty(int target = 0) const { return !(_anyDirty & (1 << target)); }
+    // Cell rectangles covering every tile dirty for target, clipped to the
+    // grid and sorted top to bottom
+    const std::vector<Rect> &rects(int target = 0);
+};
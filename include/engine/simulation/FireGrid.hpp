@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/core/Rect.hpp"
+
+// Authoritative fire state, one bit per cell packed 64 cells to a word.
+// Every row starts on a word boundary so kernels can shift whole words without
+// straddling rows; padding bits past the right edge are always kept clear.
+class FireGrid {
+private:
+    int _width;
+    int _height;
+    int _wordsPerRow;
+    std::vector<uint64_t> _burning;
+
+public:
+    FireGrid();
+    FireGrid(int width, int height);
+
+    void resize(int width, int height);
+    void clear();
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    int wordsPerRow() const { return _wordsPerRow; }
+    size_t wordCount() const { return _burning.size(); }
+
+    uint64_t *row(int y) { return _burning.data() + static_cast<size_t>(y) * _wordsPerRow; }
+    const uint64_t *row(int y) const { return _burning.data() + static_cast<size_t>(y) * _wordsPerRow; }
+    uint64_t *words() { return _burning.data(); }
+    const uint64_t *words() const { return _burning.data(); }
+
+    // Mask of the bits that hold real cells in the last word of every row
+    uint64_t lastWordMask() const;
+
+    bool isBurning(int x, int y) const;
+    // Both return true when the cell actually changed state
+    bool ignite(int x, int y);
+    bool extinguish(int x, int y);
+
+    size_t burningCount() const;
+};
+
+// Palette index of a cell in the indexed background
+enum class FireCellState : uint8_t {
+    Forest,
+    Burning,
+    // Burnt at some point and no longer burning
+    Extinguished
+};
+
+// Expands the grid into tightly packed RGBA pixels (width * height * 4 bytes)
+void colorizeFireGrid(const FireGrid &grid, unsigned char *rgba);
+// Same for the cells inside rect only, pixels outside it are left untouched
+void colorizeFireGrid(const FireGrid &grid, unsigned char *rgba, const Rect &rect);
+// Writes the FireCellState of every cell inside rect as one byte per cell
+// into cells (width * height bytes). Without a burned grid nothing is shown
+// as extinguished.
+void indexFireGrid(const FireGrid &grid, const FireGrid *burned, uint8_t *cells, const Rect &rect);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/simulation/FireGrid.hpp"
+
+// The last few recorded fire generations, kept compressed for rewind and
+// replay. Each record is the XOR of its grid with the previous record's, and
+// every keyframeInterval-th record is XORed with an empty grid instead so it
+// decodes on its own. Both are stored as alternating runs of zero and non-zero
+// words with varint run lengths, so a generation costs roughly the words its
+// fire front touched. Restoring decodes at most keyframeInterval records.
+class FireHistory {
+private:
+    struct Record {
+        uint64_t generation;
+        bool keyframe;
+        std::vector<uint8_t> data;
+    };
+
+    size_t _capacity;
+    int _keyframeInterval;
+    int _width;
+    int _height;
+    // Ring of records, oldest at _first
+    std::vector<Record> _records;
+    size_t _first;
+    size_t _count;
+    // Records since the last keyframe, including it
+    int _sinceKeyframe;
+    // Grid of the newest record, what the next delta is taken against
+    FireGrid _last;
+    // Scratch for re-encoding a record as a keyframe
+    FireGrid _scratch;
+
+    const Record &at(size_t i) const { return _records[(_first + i) % _capacity]; }
+    Record &at(size_t i) { return _records[(_first + i) % _capacity]; }
+    // Index of the record of generation, or _count when there is none
+    size_t find(uint64_t generation) const;
+    void dropOldest();
+
+    // data encodes grid XOR base, base being null for an empty grid
+    static void encode(const FireGrid &grid, const FireGrid *base, std::vector<uint8_t> &data);
+    // XORs the decoded words into grid
+    static void apply(const std::vector<uint8_t> &data, FireGrid &grid);
+
+public:
+    explicit FireHistory(size_t capacity = 256, int keyframeInterval = 32);
+
+    void clear();
+    // Appends a generation, dropping the oldest one when the history is full.
+    // Generations must be recorded in increasing order and all grids share one size.
+    void record(const FireGrid &grid, uint64_t generation);
+    // Writes the grid of a recorded generation into grid, false when it is not kept
+    bool restore(uint64_t generation, FireGrid &grid) const;
+
+    bool empty() const { return _count == 0; }
+    size_t size() const { return _count; }
+    size_t capacity() const { return _capacity; }
+    int keyframeInterval() const { return _keyframeInterval; }
+    uint64_t oldestGeneration() const { return _count ? at(0).generation : 0; }
+    uint64_t newestGeneration() const { return _count ? at(_count - 1).generation : 0; }
+    bool contains(uint64_t generation) const { return find(generation) < _count; }
+    // Encoded bytes of every kept record
+    size_t memoryBytes() const;
+};
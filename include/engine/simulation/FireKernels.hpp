@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "engine/core/Random.hpp"
+#include "engine/simulation/FireGrid.hpp"
+
+// Implementations of the per-row fire spread step. Both produce bit-identical
+// output; Reference walks cell by cell and exists to validate Scalar, which
+// works a 64-cell word at a time and is the one the simulation runs.
+enum class FireKernel {
+    Reference,
+    Scalar
+};
+
+// Everything a row kernel needs to step one generation
+struct FireStepContext {
+    const FireGrid *src;
+    FireGrid *dst;
+    // CounterRng lane keys of the generation, indexed by FireSimulation::Direction.
+    // The roll for a cell is CounterRng::hash32(cell index ^ key).
+    const uint32_t *streamKeys;
+    // Per-direction limits, a roll succeeds when its hash is below the limit of
+    // its direction. With flammability set they are scales instead and the
+    // limit of a cell is its flammability times the scale.
+    const uint32_t *thresholds;
+    // Optional ForestCells flammability, rows stride bytes apart
+    const uint8_t *flammability;
+    size_t flammabilityStride;
+};
+
+// Writes words [wordBegin, wordEnd) of row y of ctx.dst from ctx.src
+using FireRowKernel = void (*)(const FireStepContext &ctx, int y, int wordBegin, int wordEnd);
+
+const char *fireKernelName(FireKernel kernel);
+FireRowKernel fireRowKernel(FireKernel kernel);
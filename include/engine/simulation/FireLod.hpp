@@ -0,0 +1,76 @@
+#pragma once
+
+#include <future>
+#include <vector>
+
+#include "engine/simulation/FireGrid.hpp"
+#include "engine/simulation/FireSimulation.hpp"
+#include "engine/simulation/ForestCells.hpp"
+
+// Coarse level of detail for a FireSimulation. While active, the fire runs on
+// a grid of factor x factor blocks: a block burns when any of its cells did,
+// forest fields are averaged over the block and wind is taken from the block
+// region's centre. The coarse spread chance is calibrated so that the fire
+// front covers the same distance per generation, so switching back and forth
+// keeps the overall spread speed; the outline within a block is lost.
+class FireLod {
+public:
+    // Largest block size, a block has to fit into one grid word with room to shift
+    static constexpr int MaxFactor = 32;
+
+private:
+    int _factor;
+    // Chunks of the fine simulation, see FireSimulation::chunksX
+    int _fineChunksX;
+    int _fineChunksY;
+    FireSimulation _coarse;
+    ForestCells _coarseForest;
+    bool _active;
+    uint64_t _startGeneration;
+    uint64_t _steps;
+    // Fine chance the coarse chance is being calibrated for, and the result
+    float _calibratedFor;
+    std::shared_future<float> _calibratedChance;
+    std::vector<int> _changedCoarse;
+
+public:
+    // factor is rounded down to a power of two in [2, MaxFactor]
+    FireLod(int fineWidth, int fineHeight, int factor);
+
+    // Coarse spread chance whose front moves factor times fewer cells per
+    // generation than fineChance, measured by stepping both on small grids.
+    // Takes tens of milliseconds the first time; results are cached per
+    // (fineChance, factor) and the cache is shared between threads.
+    static float calibratedChance(float fineChance, int factor);
+    // Starts calibrating for fineChance on a thread of its own, so enter does
+    // not have to wait for it
+    void prepare(float fineChance);
+
+    int factor() const { return _factor; }
+    bool active() const { return _active; }
+
+    // Takes over the state of fine and runs coarse from here on
+    void enter(const FireSimulation &fine);
+    // Writes the coarse state back into fine: cells of burning blocks catch
+    // fire, cells of blocks that were put out are extinguished
+    void leave(FireSimulation &fine);
+
+    // One generation of the fine simulation
+    void step();
+    // Generation the fine simulation would be at
+    uint64_t generation() const { return _startGeneration + _steps; }
+
+    // Sets the block of fine cell (x, y) on fire
+    bool ignite(int x, int y);
+    // Puts out every block the fine span [x0, x1) of row y touches
+    bool extinguishSpan(int y, int x0, int x1);
+    // Burning blocks at full resolution, grid must have the fine size
+    void expand(FireGrid &grid) const;
+    // Same for the cells of one fine chunk only
+    void expandChunk(FireGrid &grid, int chunk) const;
+    // Appends every fine chunk whose blocks changed since the last call, a
+    // chunk may be listed more than once
+    void takeChangedChunks(std::vector<int> &chunks);
+
+    const FireSimulation &coarse() const { return _coarse; }
+};
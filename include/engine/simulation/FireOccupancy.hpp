@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/simulation/FireGrid.hpp"
+
+// Summary of where a FireGrid burns. A tile is one grid word wide and
+// TileSize rows tall and holds one bit per row word, set when any of its 64
+// cells burns, so a tile without fire reads as zero. The summary is not
+// updated by the grid itself, whoever writes the grid keeps it in sync.
+class FireOccupancy {
+public:
+    static constexpr int TileSize = 64;
+
+private:
+    int _tilesX;
+    int _tilesY;
+    std::vector<uint64_t> _rows;
+
+public:
+    FireOccupancy();
+
+    void resize(int width, int height);
+    void rebuild(const FireGrid &grid);
+
+    int tilesX() const { return _tilesX; }
+    int tilesY() const { return _tilesY; }
+
+    // Bit r is set when row r of the tile holds fire
+    uint64_t rows(int tile) const { return _rows[tile]; }
+
+    // Different tiles can be set from several threads at once
+    void setRows(int tile, uint64_t rows) { _rows[tile] = rows; }
+    // Refreshes the bit of one row word of a tile
+    void updateRow(int tile, int row, uint64_t word);
+};
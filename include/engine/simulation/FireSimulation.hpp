@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <span>
+#include <vector>
+
+#include "engine/simulation/FireBrush.hpp"
+#include "engine/simulation/FireGrid.hpp"
+#include "engine/simulation/FireKernels.hpp"
+#include "engine/simulation/FireOccupancy.hpp"
+#include "engine/simulation/FireStatistics.hpp"
+#include "engine/simulation/WindField.hpp"
+
+class ForestCells;
+class WorkerPool;
+
+enum class FireStepMode {
+    // Runs the row kernel over every awake chunk on the calling thread
+    Dense,
+    // Visits only burning cells that still have unburnt neighbours
+    Frontier,
+    // Steps the awake TileSize x TileSize chunks in parallel
+    Tiled,
+    // Schedules each ignition at an exact continuous time on a priority queue;
+    // does not follow the generation rolls of the other modes
+    Event
+};
+
+// Owns the fire grid and advances it one generation at a time. The dense and
+// tiled steps run a row kernel that reads the front grid and writes the back
+// grid, then the two are swapped.
+//
+// Those steps work on TileSize x TileSize chunks that are either awake or
+// asleep. A chunk falls asleep once none of its unburnt cells touches fire and
+// is then skipped entirely; it wakes when fire reaches its border, or when
+// cells inside it are ignited or extinguished from outside the step.
+//
+// Every spread roll is a pure function of (seed, generation, target cell,
+// direction), so the generational modes produce identical grids for the same
+// seed no matter in which order or on which thread cells are visited. The
+// event mode draws spread delays from the same per-generation chances, so it
+// spreads at the same average speed but along different random paths.
+class FireSimulation {
+public:
+    // Tiles (chunks) are one word wide, so no two tiles ever write the same word
+    static constexpr int TileSize = 64;
+    static_assert(WindField::RegionSize == TileSize && FireOccupancy::TileSize == TileSize &&
+                  FireStatistics::TileSize == TileSize);
+
+    // Direction the fire comes from, seen from the cell being ignited
+    enum Direction {
+        FromLeft = 0,
+        FromRight = 1,
+        FromAbove = 2,
+        FromBelow = 3
+    };
+    // Way the fire travels for each Direction, in cells
+    static constexpr int TravelX[4] = {1, -1, 0, 0};
+    static constexpr int TravelY[4] = {0, 0, 1, -1};
+
+private:
+    FireGrid _front;
+    FireGrid _back;
+    float _spreadChance;
+    const ForestCells *_forest;
+    WindField _wind;
+    // Spread limits per wind bucket and direction, the kernels' thresholds
+    std::vector<uint32_t> _thresholds;
+    FireStepMode _mode;
+    FireKernel _kernel;
+    FireRowKernel _rowKernel;
+    WorkerPool *_workers;
+
+    uint64_t _seed;
+    uint64_t _generation;
+    // Per-direction hash keys of the current generation, derived from seed and generation
+    uint32_t _streamKeys[4];
+
+    // Cell indices (y * width + x) of the active frontier, deduplicated by _inFrontier
+    std::vector<uint32_t> _frontier;
+    std::vector<uint32_t> _nextFrontier;
+    std::vector<uint32_t> _ignitions;
+    FireGrid _inFrontier;
+
+    struct FireEvent {
+        // Time in generations at which target catches fire
+        double time;
+        uint32_t target;
+        uint32_t source;
+
+        bool operator>(const FireEvent &other) const { return time > other.time; }
+    };
+    // Simulated time in generations, advanced continuously by the event mode
+    double _time;
+    std::priority_queue<FireEvent, std::vector<FireEvent>, std::greater<FireEvent>> _events;
+
+    enum ChunkFlag : uint8_t {
+        // Stepped next generation
+        ChunkAwake = 1,
+        // Back grid differs from the front grid inside the chunk
+        ChunkStale = 2,
+        // Changed during the current step
+        ChunkChanged = 4,
+        // Already queued for classification in the current step
+        ChunkQueued = 8,
+        // Perimeter has to be recounted after the current step
+        ChunkRecount = 16,
+        // Front or burned cells changed since takeChangedChunks last ran
+        ChunkDirty = 32
+    };
+
+    int _chunksX;
+    int _chunksY;
+    bool _sleepingChunks;
+    std::vector<uint8_t> _chunkFlags;
+    // Chunk indices, each list deduplicated by the matching flag
+    std::vector<int> _awakeChunks;
+    std::vector<int> _staleChunks;
+    std::vector<int> _classifyChunks;
+    std::vector<int> _dirtyChunks;
+    // Where _front and _back burn, swapped along with them. Chunks are the
+    // occupancy tiles.
+    FireOccupancy _occupancy;
+    FireOccupancy _backOccupancy;
+
+    // Every cell that has ever burnt
+    FireGrid _burned;
+    FireStatistics _statistics;
+
+    // A time-sliced step has stepped the awake chunks before _sliceCursor
+    bool _stepInProgress;
+    size_t _sliceCursor;
+    // Edits held back until the step in progress is published
+    struct FireEdit {
+        int x, y, width, height;
+        bool ignite;
+    };
+    std::vector<FireEdit> _deferredEdits;
+
+    void stepFrontier();
+    void beginChunkStep();
+    void stepChunkRange(size_t begin, size_t end);
+    void finishChunkStep();
+    void finishGeneration();
+    void stepChunk(const FireStepContext &ctx, int chunk);
+    // Rows of a chunk whose word or neighbouring words hold fire in the front grid
+    uint64_t chunkRowsNearFire(int chunk) const;
+    // Rows of a chunk that can own perimeter edges in the front grid
+    uint64_t chunkRowsOwningEdges(int chunk) const;
+    bool chunkHasFuelNextToFire(int chunk) const;
+    // Runs job on the worker pool in tiled mode and serially otherwise
+    void forEachChunk(std::span<const int> chunks, const std::function<void(int)> &job);
+    FireStepContext stepContext();
+    void updateStreamKeys();
+    void updateThresholds();
+
+    void pushFrontier(int x, int y);
+    void pushBurningNeighbours(int x, int y);
+    void rebuildFrontier();
+
+    uint32_t spreadLimit(int x, int y, Direction dir) const;
+    void scheduleSpread(int sourceX, int sourceY, Direction dir, double start);
+    void scheduleNeighbours(int x, int y, double start);
+    void rebuildEvents();
+    // Keeps the frontier or event queue in sync with a cell that was put out
+    void cellExtinguished(int x, int y);
+
+    // Change a single front grid cell and keep the statistics in sync
+    bool igniteCell(int x, int y);
+    bool extinguishCell(int x, int y);
+    // Puts out the cells of mask in word w of row y
+    bool extinguishWord(int w, int y, uint64_t mask);
+    // Puts out the cells of [x0, x1) x [y0, y1) inside chunk (w, chunkY),
+    // skipping rows without fire
+    bool extinguishInChunk(int w, int chunkY, int x0, int x1, int y0, int y1);
+
+    void setChunkFlag(int chunk, ChunkFlag flag, std::vector<int> &list);
+    void wakeAll();
+    // Marks a cell changed from outside the step and wakes the chunks it can affect
+    void touchCell(int x, int y);
+
+public:
+    FireSimulation(int width, int height, float spreadChance = 0.3f, uint64_t seed = 0);
+
+    // Advances one generation, finishing a time-sliced step if one is running
+    void step();
+
+    // Time-sliced stepping for the dense and tiled modes. beginStep starts a
+    // generation, each continueStep steps about fraction of its awake chunks
+    // into the back grid and the call that completes it publishes the
+    // generation and returns true. The other modes step in full in beginStep,
+    // which then returns true. Edits made while a step is running are queued,
+    // return false and apply right after it is published.
+    bool beginStep();
+    bool continueStep(float fraction);
+    bool stepInProgress() const { return _stepInProgress; }
+    // Advances by a fraction of a generation. The event mode processes exactly
+    // the ignitions due in that time, the other modes step each generation
+    // boundary crossed. Returns the number of generations stepped or, in event
+    // mode, of cells ignited.
+    size_t advance(double generations);
+
+    bool ignite(int x, int y);
+    bool extinguish(int x, int y);
+    // Extinguishes every cell of the clipped rectangle, skipping chunks without fire.
+    // Returns true when any cell changed.
+    bool extinguishRect(int x, int y, int width, int height);
+    // Extinguishes cells [x0, x1) of row y, clipped to the grid
+    bool extinguishSpan(int y, int x0, int x1);
+    // Applies every merged span of the batch
+    bool extinguishStamps(FireStampBatch &stamps);
+    // Puts out every cell, forgets which cells burned and rewinds to
+    // generation 0. Seed, mode, kernel, forest and wind are kept.
+    void reset();
+
+    // True when the cell at (x, y) catches fire from its neighbour in direction
+    // dir during the current generation
+    bool spreads(int x, int y, Direction dir) const;
+
+    const FireGrid &grid() const { return _front; }
+    const FireGrid &burned() const { return _burned; }
+    // Burning count, burnt area, perimeter and per-chunk damage, kept up to
+    // date by every mode
+    const FireStatistics &statistics() const { return _statistics; }
+    // Base chance that fire spreads to a neighbour in one generation
+    float spreadChance() const { return _spreadChance; }
+    void setSpreadChance(float chance);
+
+    // Scales the spread chance of every cell by its flammability. The forest
+    // must match the grid size and outlive the simulation; null restores the
+    // uniform spread chance.
+    const ForestCells *forest() const { return _forest; }
+    void setForest(const ForestCells *forest);
+
+    // Wind per chunk, changes take effect on the next step
+    WindField &wind() { return _wind; }
+    const WindField &wind() const { return _wind; }
+
+    uint64_t seed() const { return _seed; }
+    void setSeed(uint64_t seed);
+    uint64_t generation() const { return _generation; }
+    // Jumps to a generation without stepping, for a grid that was advanced elsewhere
+    void setGeneration(uint64_t generation);
+    double time() const { return _time; }
+
+    FireStepMode mode() const { return _mode; }
+    void setMode(FireStepMode mode);
+    size_t frontierSize() const { return _frontier.size(); }
+    size_t pendingEvents() const { return _events.size(); }
+
+    FireKernel kernel() const { return _kernel; }
+    void setKernel(FireKernel kernel);
+
+    // Pool used by the tiled mode, without one tiles are stepped serially
+    void setWorkerPool(WorkerPool *workers) { _workers = workers; }
+
+    // With sleeping disabled every chunk is stepped every generation
+    bool sleepingChunks() const { return _sleepingChunks; }
+    void setSleepingChunks(bool enabled);
+    size_t awakeChunkCount() const { return _awakeChunks.size(); }
+    // Only kept up to date by the dense and tiled modes
+    const FireOccupancy &occupancy() const { return _occupancy; }
+
+    // Chunks are one grid word wide and TileSize rows tall, numbered row by row
+    int chunksX() const { return _chunksX; }
+    int chunksY() const { return _chunksY; }
+    // Appends every chunk whose front or burned cells changed since the last
+    // call, in any mode, each once
+    void takeChangedChunks(std::vector<int> &chunks);
+};
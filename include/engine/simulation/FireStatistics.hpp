@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine/simulation/FireGrid.hpp"
+
+// Aggregates of a fire, kept per tile and in total
+struct FireTileStats {
+    // Cells burning right now
+    uint32_t burning = 0;
+    // Cells that have burnt at some point
+    uint32_t burned = 0;
+    // Edges between a burning and a non-burning cell
+    uint32_t perimeter = 0;
+};
+
+// Incrementally maintained fire statistics. Tiles are one grid word wide and
+// TileSize rows tall, like FireOccupancy. The edges between a cell and its
+// right and lower neighbours count towards the cell's tile, so every edge
+// belongs to exactly one tile.
+//
+// The step computes the new counts of many tiles on several threads at once
+// and hands them over with setPending; commit merges them into the totals.
+// Single cells changed outside a step are applied with cellChanged.
+class FireStatistics {
+public:
+    static constexpr int TileSize = 64;
+
+private:
+    int _tilesX;
+    int _tilesY;
+    std::vector<FireTileStats> _tiles;
+    std::vector<FireTileStats> _pending;
+    uint64_t _burning;
+    uint64_t _burned;
+    uint64_t _perimeter;
+
+    void addPerimeter(int x, int y, int delta);
+
+public:
+    FireStatistics();
+
+    // Resets every count to zero
+    void resize(int width, int height);
+
+    // Perimeter edges owned by a tile, only rows set in the rows mask are
+    // visited and the others must not own any
+    static uint32_t countPerimeter(const FireGrid &grid, int tile, uint64_t rows);
+    const FireTileStats &pending(int tile) const { return _pending[tile]; }
+    void setPending(int tile, const FireTileStats &stats) { _pending[tile] = stats; }
+    void commit(int tile);
+
+    // Call after the cell at (x, y) of grid caught fire or was put out.
+    // newlyBurned is set when the cell burns for the first time.
+    void cellChanged(const FireGrid &grid, int x, int y, bool newlyBurned);
+
+    uint64_t burningCount() const { return _burning; }
+    uint64_t burnedArea() const { return _burned; }
+    uint64_t perimeter() const { return _perimeter; }
+
+    int tilesX() const { return _tilesX; }
+    int tilesY() const { return _tilesY; }
+    const FireTileStats &tile(int tile) const { return _tiles[tile]; }
+    // Burnt cells in tiles [tileX0, tileX1) x [tileY0, tileY1)
+    uint64_t regionDamage(int tileX0, int tileY0, int tileX1, int tileY1) const;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "engine/core/SpscQueue.hpp"
+#include "engine/core/TripleBuffer.hpp"
+#include "engine/simulation/FireBrush.hpp"
+#include "engine/simulation/FireGrid.hpp"
+
+class FireLod;
+class FireSimulation;
+
+// Fire state as published by the fire thread
+struct FireSnapshot {
+    FireGrid grid;
+    // Cells that have burnt at some point, left as it was while coarse
+    FireGrid burned;
+    uint64_t generation = 0;
+    size_t burningCount = 0;
+    size_t burnedArea = 0;
+    size_t perimeter = 0;
+    // Time the last step took
+    double stepMilliseconds = 0.0;
+    // Per chunk of FireSimulation, changes whenever the chunk of grid or
+    // burned changes, so readers can skip the chunks they have seen already
+    std::vector<uint32_t> chunkVersions;
+};
+
+// Edit sent from the owning thread to the fire thread
+struct FireCommand {
+    enum Type : uint8_t {
+        Extinguish,
+        Ignite,
+        SetDetail
+    };
+
+    Type type;
+    // Cells [x0, x1) of row y, a single cell for Ignite. SetDetail switches to
+    // the coarse level of detail when x0 is set and back to full otherwise.
+    int y;
+    int x0;
+    int x1;
+};
+
+// Runs a FireSimulation on its own thread, one generation every
+// generationSeconds (event mode advances continuously). Edits arrive through a
+// single-producer/single-consumer queue and changes are published as a
+// FireSnapshot through a triple buffer, so the owning thread never waits on
+// the fire. Every step is published right away, edits and event mode progress
+// at most once per PublishInterval. Only the chunks that changed since a
+// snapshot slot was last written are copied into it. While running, the
+// simulation must not be touched by any other thread.
+class FireThread {
+private:
+    FireSimulation &_fire;
+    // Optional coarse level of detail, stepped instead of _fire while active
+    FireLod *_lod;
+    double _generationSeconds;
+    std::thread _thread;
+    std::atomic<bool> _stopping;
+    SpscQueue<FireCommand> _commands;
+    TripleBuffer<FireSnapshot> _snapshots;
+    // Commands lost because the queue was full
+    std::atomic<size_t> _droppedCommands;
+    // Bumped for every chunk that changed, compared against the versions of
+    // the snapshot being written
+    std::vector<uint32_t> _chunkVersions;
+    uint32_t _publishCount;
+    std::vector<int> _changedChunks;
+    // Set when the level of detail switched and every chunk has to be copied
+    bool _allChanged;
+
+    void run();
+    bool applyCommands();
+    void publish(double stepMilliseconds);
+    void copyChunk(FireSnapshot &snapshot, int chunk);
+    bool push(const FireCommand &command);
+
+public:
+    explicit FireThread(FireSimulation &fire, double generationSeconds = 1.0, size_t commandCapacity = 16384);
+    ~FireThread();
+
+    FireThread(const FireThread &) = delete;
+    FireThread &operator=(const FireThread &) = delete;
+
+    void start();
+    // Joins the thread, queued commands that were not applied yet are dropped
+    void stop();
+    bool running() const { return _thread.joinable(); }
+    // Must be set before start, the thread owns it from then on
+    void setLod(FireLod *lod) { _lod = lod; }
+
+    // Producer side, called from one thread only. Return false when the queue
+    // was full and the edit (or part of the batch) was dropped.
+    bool ignite(int x, int y);
+    bool extinguishSpan(int y, int x0, int x1);
+    bool extinguishStamps(FireStampBatch &stamps);
+    bool setCoarse(bool coarse);
+    size_t droppedCommands() const { return _droppedCommands.load(std::memory_order_relaxed); }
+
+    // Consumer side, called from one thread only. Returns the newest snapshot
+    // when one was published since the last call and null otherwise.
+    const FireSnapshot *acquire();
+    // Last snapshot returned by acquire
+    const FireSnapshot &latest() const { return _snapshots.front(); }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-cell forest properties stored as separate contiguous arrays, one byte
+// per cell and field. Every array shares the same row stride, padded to a
+// whole fire grid word, so the fire kernels can load the 64 cells of a word
+// at once. Whether a cell burns lives in the FireGrid bitplane.
+//
+// Fuel, moisture and heat combine into a flammability byte per cell: 128
+// spreads at the base spread chance, 255 at about twice that and 0 never.
+class ForestCells {
+private:
+    int _width;
+    int _height;
+    size_t _stride;
+    std::vector<uint8_t> _fuel;
+    std::vector<uint8_t> _moisture;
+    std::vector<uint8_t> _heat;
+    std::vector<uint8_t> _flammability;
+
+public:
+    ForestCells();
+    ForestCells(int width, int height);
+
+    void resize(int width, int height);
+    // Fills fuel, moisture and heat with Perlin noise whose patches are roughly
+    // featureSize cells across, then updates the flammability
+    void generate(unsigned int seed, float featureSize = 64.0f);
+    // Must be called after writing to fuel, moisture or heat
+    void updateFlammability();
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    // Distance in bytes between two rows of every array
+    size_t stride() const { return _stride; }
+
+    uint8_t *fuel() { return _fuel.data(); }
+    const uint8_t *fuel() const { return _fuel.data(); }
+    uint8_t *moisture() { return _moisture.data(); }
+    const uint8_t *moisture() const { return _moisture.data(); }
+    uint8_t *heat() { return _heat.data(); }
+    const uint8_t *heat() const { return _heat.data(); }
+    const uint8_t *flammability() const { return _flammability.data(); }
+
+    uint8_t flammability(int x, int y) const { return _flammability[static_cast<size_t>(y) * _stride + x]; }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Wind over the fire grid, one value per region of RegionSize x RegionSize
+// cells. Directions and strengths are quantized into a small set of buckets
+// so the fire step can look spread thresholds up in a table per bucket
+// instead of doing float math per cell.
+class WindField {
+public:
+    // Regions match the fire simulation chunks
+    static constexpr int RegionSize = 64;
+    static constexpr int AngleSteps = 16;
+    static constexpr int StrengthSteps = 8;
+    static constexpr int BucketCount = AngleSteps * StrengthSteps;
+
+private:
+    int _regionsX;
+    int _regionsY;
+    std::vector<uint8_t> _buckets;
+
+public:
+    WindField();
+    WindField(int width, int height);
+
+    void resize(int width, int height);
+
+    // angle is the direction the wind blows towards in radians, 0 along +x and
+    // pi / 2 along +y. strength runs from 0 (calm) to 1.
+    static uint8_t bucket(float angle, float strength);
+    // How much faster fire travelling along (dx, dy) spreads in the given bucket
+    static float spreadFactor(uint8_t bucket, int dx, int dy);
+
+    void setUniform(float angle, float strength);
+    void setRegion(int regionX, int regionY, float angle, float strength);
+    void setRegionBucket(int region, uint8_t bucket) { _buckets[region] = bucket; }
+
+    int regionsX() const { return _regionsX; }
+    int regionsY() const { return _regionsY; }
+    uint8_t regionBucket(int region) const { return _buckets[region]; }
+    uint8_t cellBucket(int x, int y) const { return _buckets[(y / RegionSize) * _regionsX + x / RegionSize]; }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// Size of the fire grid and how it maps onto the playable area. The world
+// spans [-halfExtent, halfExtent] on both axes and the grid covers it edge to
+// edge, so every system sizing a buffer or converting positions goes through
+// this one descriptor.
+struct WorldDimensions {
+    int gridWidth = 200;
+    int gridHeight = 200;
+    float halfExtent = 100.0f;
+
+    size_t cellCount() const { return static_cast<size_t>(gridWidth) * gridHeight; }
+
+    float cellsPerUnitX() const { return (gridWidth - 1) / (2.0f * halfExtent); }
+    float cellsPerUnitY() const { return (gridHeight - 1) / (2.0f * halfExtent); }
+
+    // Convert world coordinates from [-halfExtent, halfExtent] to [0, grid size - 1]
+    int worldToCellX(float x) const { return static_cast<int>((x + halfExtent) * cellsPerUnitX()); }
+    int worldToCellY(float y) const { return static_cast<int>((y + halfExtent) * cellsPerUnitY()); }
+};
@@ -3,21 +3,63 @@
 #include <IniCM/IniConfManager.hpp>
 #include <IniCM/IniConfEntry.hpp>
 
+#include "engine/simulation/WorldDimensions.hpp"
 #include "utils/PathUtils.hpp"
 
 namespace conf {
-    IniConfEntry::Integer windowWidth("WindowWidth", "Determines the x resolution of the window", 1000);
-    IniConfEntry::Integer windowHeight("WindowHeight", "Determines the y resolution of the window", 1000);
+    inline IniConfEntry::Integer windowWidth("WindowWidth", "Determines the x resolution of the window", 1000);
+    inline IniConfEntry::Integer windowHeight("WindowHeight", "Determines the y resolution of the window", 1000);
 
-    IniConfEntry::Boolean fullscreen("Fullscreen", "Whether the window should be fullscreen", false);
+    inline IniConfEntry::Boolean fullscreen("Fullscreen", "Whether the window should be fullscreen", false);
 
-    void init() {
+    inline IniConfEntry::Integer seed("Seed", "Seed for enemies and fire, the same seed replays the same game. 0 picks a new seed every run", 0);
+
+    inline IniConfEntry::Integer fireGridWidth("FireGridWidth", "Number of fire cells across the world", 200);
+    inline IniConfEntry::Integer fireGridHeight("FireGridHeight", "Number of fire cells down the world", 200);
+    inline IniConfEntry::Integer fireStepMode("FireStepMode", "Fire step: 0 dense, 1 frontier, 2 tiled on worker threads, 3 event driven", 1);
+    inline IniConfEntry::Integer fireThreads("FireThreads", "Worker threads for the tiled fire step, 0 uses every hardware thread", 0);
+    inline IniConfEntry::Integer fireStepSlices("FireStepSlices", "Updates each dense or tiled fire generation is spread over, 1 steps it at once", 1);
+    inline IniConfEntry::Boolean fireThread("FireThread", "Step the fire on its own thread so the game never waits for it", true);
+    inline IniConfEntry::Integer fireHistoryLength("FireHistoryLength", "Fire generations kept for scrubbing with the arrow keys, 0 disables the history", 256);
+    inline IniConfEntry::Integer fireKeyframeInterval("FireKeyframeInterval", "Generations between full fire history frames, the others store only changes", 32);
+    inline IniConfEntry::Integer fireLodFactor("FireLodFactor", "Cells per side of the coarse fire blocks Z switches to, 2 or 4. 0 disables the coarse detail", 4);
+    inline IniConfEntry::Boolean paletteBackground("PaletteBackground", "Upload one palette index per fire cell and colour it in the shader instead of uploading colours", true);
+    inline IniConfEntry::Boolean instancedSprites("InstancedSprites", "Draw sprites as instances of one quad instead of batching their vertices", false);
+    inline IniConfEntry::Integer windDirection("WindDirection", "Direction the wind blows towards in degrees, 0 is east and 90 north", 0);
+    inline IniConfEntry::Integer windStrength("WindStrength", "Wind strength in percent, 0 is calm", 0);
+    inline IniConfEntry::Integer extinguishShape("ExtinguishShape", "Area entities put out around them: 0 square, 1 circle", 0);
+    inline IniConfEntry::Boolean forestModel("ForestModel", "Vary fuel, moisture and heat across the map so fire spreads unevenly", true);
+
+    inline void init() {
         IniConfManager manager(PathUtils::absolutePath("settings.ini"));    
 
         manager.addEntry(&windowWidth);
         manager.addEntry(&windowHeight);
         manager.addEntry(&fullscreen);
+        manager.addEntry(&seed);
+        manager.addEntry(&fireGridWidth);
+        manager.addEntry(&fireGridHeight);
+        manager.addEntry(&fireStepMode);
+        manager.addEntry(&fireThreads);
+        manager.addEntry(&fireStepSlices);
+        manager.addEntry(&fireThread);
+        manager.addEntry(&fireHistoryLength);
+        manager.addEntry(&fireKeyframeInterval);
+        manager.addEntry(&fireLodFactor);
+        manager.addEntry(&paletteBackground);
+        manager.addEntry(&instancedSprites);
+        manager.addEntry(&windDirection);
+        manager.addEntry(&windStrength);
+        manager.addEntry(&extinguishShape);
+        manager.addEntry(&forestModel);
 
         manager.build();
     }
+
+    inline WorldDimensions worldDimensions() {
+        WorldDimensions world;
+        world.gridWidth = fireGridWidth.getValue() > 0 ? fireGridWidth.getValue() : 200;
+        world.gridHeight = fireGridHeight.getValue() > 0 ? fireGridHeight.getValue() : 200;
+        return world;
+    }
 };
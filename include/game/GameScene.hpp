@@ -1,8 +1,22 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <entt/entt.hpp>
 
+#include "engine/core/Random.hpp"
+#include "engine/core/WorkerPool.hpp"
 #include "engine/rendering/RenderWindow.hpp"
+#include "engine/simulation/FireBrush.hpp"
+#include "engine/simulation/FireDirtyRects.hpp"
+#include "engine/simulation/FireHistory.hpp"
+#include "engine/simulation/FireLod.hpp"
+#include "engine/simulation/FireSimulation.hpp"
+#include "engine/simulation/FireThread.hpp"
+#include "engine/simulation/ForestCells.hpp"
+#include "engine/simulation/WorldDimensions.hpp"
 
 class SceneBase {
 protected:
@@ -22,17 +36,63 @@ class GameScene : public SceneBase {
 private:
     entt::registry _registry;
 
-    GLubyte *_backgroundTextureBuffer;
+    CounterRng _rng;
+    // Fixed update ticks since init, the counter for per-tick random draws
+    uint64_t _tick;
+
+    WorldDimensions _world;
+    ForestCells _forest;
+    FireSimulation _fire;
+    std::unique_ptr<WorkerPool> _fireWorkers;
+    // Updates each fire generation is spread over, and the time spent on it so far
+    int _fireStepSlices;
+    double _fireStepTime;
+    // Coarse level of detail, null when disabled
+    std::unique_ptr<FireLod> _fireLod;
+    // Steps _fire off the main thread when enabled, _fire is then only touched
+    // through it. Declared after everything it steps so it is destroyed first.
+    std::unique_ptr<FireThread> _fireThread;
+    bool _fireCoarse;
+    bool _detailKeyDown;
+    // Coarse fire expanded to full resolution for drawing
+    FireGrid _lodGrid;
+    // Recent generations for scrubbing, null when disabled
+    std::unique_ptr<FireHistory> _fireHistory;
+    bool _replaying;
+    uint64_t _replayGeneration;
+    FireGrid _replayGrid;
+    FireBrush _extinguishBrush;
+    FireStampBatch _extinguishStamps;
+    // Set whenever the fire grid changed since the background was last colorized
+    bool _backgroundDirty;
+    // Parts of the background that differ from the shown grid
+    FireDirtyRects _backgroundRects;
+    // Chunk versions of the fire thread snapshot last shown, only valid while
+    // _backgroundLive says the background shows such a snapshot
+    std::vector<uint32_t> _shownChunkVersions;
+    bool _backgroundLive;
+    // Whether the palette background shows extinguished cells
+    bool _backgroundBurned;
+    // Draws entities with InstancedSpriteBatch instead of SpriteBatch
+    bool _instancedSprites;
 
     // Probbably better to have a vector of function pointers to dynamically add systems
     void handleMovement(float deltaTime);
     void handleEnemies(float deltaTime);
 
+    // Steps the fire on the main thread when no fire thread runs
+    void stepFire(float deltaTime);
+
+    // Called with x, y, width, height, texture and layer of every entity to draw
+    using EntitySubmit = std::function<void(float, float, float, float, const Texture &, int)>;
+    void submitEntities(float deltaTime, const EntitySubmit &submit);
+
     void processInput();
     void update(float deltaTime);
     void draw(float deltaTime);
 public:
-    GameScene(RenderWindow *window) : SceneBase(window) {}
+    GameScene(RenderWindow *window, const WorldDimensions &world)
+        : SceneBase(window), _tick(0), _world(world), _forest(world.gridWidth, world.gridHeight), _fire(world.gridWidth, world.gridHeight), _fireStepSlices(1), _fireStepTime(0.0), _fireCoarse(false), _detailKeyDown(false), _replaying(false), _replayGeneration(0), _backgroundDirty(true), _backgroundLive(false), _backgroundBurned(true), _instancedSprites(false) {}
     ~GameScene() override = default;
     
     void init() override;
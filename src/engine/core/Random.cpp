@@ -0,0 +1,31 @@
+#include "engine/core/Random.hpp"
+
+CounterRng CounterRng::derive(uint64_t stream) const {
+    CounterRng child;
+    child._key = mix64(_key ^ mix64(stream));
+    return child;
+}
+
+int CounterRng::range(uint64_t counter, int min, int max) const {
+    if(max <= min)
+        return min;
+    // Multiply-shift keeps the bias negligible without a division
+    uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(max) - min);
+    return min + static_cast<int>((static_cast<uint64_t>(u32(counter)) * span) >> 32);
+}
+
+void CounterRng::fillU32(uint64_t firstCounter, uint32_t *out, size_t count) const {
+    for(size_t i = 0; i < count; ++i)
+        out[i] = u32(firstCounter + i);
+}
+
+void CounterRng::fillUniform(uint64_t firstCounter, float *out, size_t count) const {
+    for(size_t i = 0; i < count; ++i)
+        out[i] = uniform(firstCounter + i);
+}
+
+void CounterRng::fillLane32(uint32_t firstCounter, uint32_t *out, size_t count) const {
+    const uint32_t key = key32();
+    for(size_t i = 0; i < count; ++i)
+        out[i] = hash32((firstCounter + static_cast<uint32_t>(i)) ^ key);
+}
@@ -0,0 +1,70 @@
+#include "engine/core/WorkerPool.hpp"
+
+WorkerPool::WorkerPool(int threadCount)
+    : _job(nullptr), _jobCount(0), _nextIndex(0), _busyWorkers(0), _epoch(0), _stopping(false) {
+    if(threadCount <= 0)
+        threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    for(int i = 1; i < threadCount; ++i)
+        _threads.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for(auto &thread: _threads)
+        thread.join();
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int)> &job) {
+    if(count <= 0)
+        return;
+
+    if(_threads.empty() || count == 1) {
+        for(int i = 0; i < count; ++i)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &job;
+        _jobCount = count;
+        _nextIndex = 0;
+        _busyWorkers = static_cast<int>(_threads.size());
+        ++_epoch;
+    }
+    _wake.notify_all();
+
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _busyWorkers == 0; });
+    _job = nullptr;
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t seenEpoch = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stopping || _epoch != seenEpoch; });
+            if(_stopping)
+                return;
+            seenEpoch = _epoch;
+        }
+
+        runJobs();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(--_busyWorkers == 0)
+            _done.notify_one();
+    }
+}
+
+void WorkerPool::runJobs() {
+    for(int i = _nextIndex.fetch_add(1); i < _jobCount; i = _nextIndex.fetch_add(1))
+        (*_job)(i);
+}
@@ -0,0 +1,99 @@
+#include "engine/rendering/InstancedSpriteBatch.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <spdlog/spdlog.h>
+
+InstancedSpriteBatch::InstancedSpriteBatch() : _program(0), _vertexArray(0), _capacity(0), _drawCalls(0) {
+}
+
+void InstancedSpriteBatch::create(GLuint unitQuad, int capacity) {
+    discard();
+    _vertexArray = unitQuad;
+    _capacity = std::max(capacity, 1);
+    _instances.create(GL_ARRAY_BUFFER, static_cast<size_t>(_capacity) * sizeof(SpriteInstance), false);
+
+    glBindVertexArray(_vertexArray);
+    for(GLuint attribute = 2; attribute <= 6; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        // Advances once per sprite instead of once per vertex
+        glVertexAttribDivisor(attribute, 1);
+    }
+    bindInstances(0);
+    glBindVertexArray(0);
+}
+
+void InstancedSpriteBatch::discard() {
+    if(!_vertexArray)
+        return;
+    _instances.discard();
+    _vertexArray = 0;
+}
+
+void InstancedSpriteBatch::bindInstances(size_t offset) {
+    // Instanced draws without a base instance always start at instance 0, so
+    // the attributes are pointed at the first instance of every draw instead
+    glBindBuffer(GL_ARRAY_BUFFER, _instances.id());
+    const GLsizei stride = sizeof(SpriteInstance);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(SpriteInstance, x)));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(SpriteInstance, width)));
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(SpriteInstance, uv)));
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void *)(offset + offsetof(SpriteInstance, layer)));
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)(offset + offsetof(SpriteInstance, tint)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedSpriteBatch::begin() {
+    _pending.clear();
+    _entries.clear();
+    _drawCalls = 0;
+}
+
+void InstancedSpriteBatch::submit(float x, float y, float width, float height, const Texture &texture, const UvRect &uv, int layer,
+                                  uint32_t tint) {
+    _entries.push_back(Entry{layer, texture.id, static_cast<uint32_t>(_pending.size())});
+    _pending.push_back(SpriteInstance{x, y, width, height, uv, static_cast<float>(layer), tint});
+}
+
+void InstancedSpriteBatch::draw(const Entry *entries, size_t count) {
+    SpriteInstance *mapped = (SpriteInstance *)_instances.map();
+    if(!mapped) {
+        spdlog::error("Failed to map sprite instance buffer");
+        return;
+    }
+    for(size_t i = 0; i < count; ++i)
+        mapped[i] = _pending[entries[i].index];
+    _instances.unmap();
+
+    glUseProgram(_program);
+    glBindVertexArray(_vertexArray);
+    for(size_t first = 0; first < count;) {
+        size_t last = first + 1;
+        while(last < count && entries[last].layer == entries[first].layer && entries[last].texture == entries[first].texture)
+            ++last;
+        bindInstances(_instances.offset() + first * sizeof(SpriteInstance));
+        glBindTexture(GL_TEXTURE_2D, entries[first].texture);
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(last - first));
+        ++_drawCalls;
+        first = last;
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    _instances.advance();
+}
+
+void InstancedSpriteBatch::end() {
+    if(!_vertexArray || _entries.empty())
+        return;
+    std::sort(_entries.begin(), _entries.end(), [](const Entry &a, const Entry &b) {
+        if(a.layer != b.layer)
+            return a.layer < b.layer;
+        if(a.texture != b.texture)
+            return a.texture < b.texture;
+        return a.index < b.index;
+    });
+    // More sprites than a slice holds are drawn a slice at a time
+    for(size_t first = 0; first < _entries.size(); first += _capacity)
+        draw(_entries.data() + first, std::min<size_t>(_capacity, _entries.size() - first));
+}
@@ -13,7 +13,8 @@
 #include "engine/rendering/Texture.hpp"
 
 RenderWindow::RenderWindow()
-    : _window(nullptr), _shaderProgram(0), _width(0), _height(0) {
+    : _window(nullptr), _shaderProgram(0), _paletteProgram(0), _backgroundTexture(0), _paletteBackground(false), _unitQuadArray(0),
+      _unitQuadVertices(0), _unitQuadIndices(0), _spriteProgram(0), _backgroundWidth(0), _backgroundHeight(0), _aspectRatio(1.0f) {
 }
 
 RenderWindow::~RenderWindow() {
@@ -32,7 +33,15 @@ void RenderWindow::discard() {
     for(auto textureId: _loadedTextures)
         glDeleteTextures(1, &textureId);
 
+    _pbo.discard();
+    _spriteBatch.discard();
+    _instancedSprites.discard();
+    glDeleteVertexArrays(1, &_unitQuadArray);
+    glDeleteBuffers(1, &_unitQuadVertices);
+    glDeleteBuffers(1, &_unitQuadIndices);
     glDeleteProgram(_shaderProgram);
+    glDeleteProgram(_paletteProgram);
+    glDeleteProgram(_spriteProgram);
 
     glfwDestroyWindow(_window);
     _window = nullptr;
@@ -81,9 +90,55 @@ int RenderWindow::init(int width, int height, const char *title, std::initialize
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     spdlog::debug("OpenGL context initialized successfully");
 
+    updateAspectRatio();
+    _spriteBatch.create();
+    createUnitQuad();
+    _instancedSprites.create(_unitQuadArray);
+
     return 0;
 }
 
+void RenderWindow::createUnitQuad() {
+    // clang-format off
+    // Same corners and texture coordinates as drawTexture, the texture
+    // coordinates select between the corners of a sprite's uv rect
+    float vertices[] = {
+        // positions    // texture coords
+         0.5f, -0.5f,   1.0f, 1.0f, // top right
+         0.5f,  0.5f,   1.0f, 0.0f, // bottom right
+        -0.5f,  0.5f,   0.0f, 0.0f, // bottom left
+        -0.5f, -0.5f,   0.0f, 1.0f  // top left
+    };
+    unsigned int indices[] = {
+        0, 1, 3, // first triangle
+        1, 2, 3  // second triangle
+    };
+    // clang-format on
+
+    glGenVertexArrays(1, &_unitQuadArray);
+    glGenBuffers(1, &_unitQuadVertices);
+    glGenBuffers(1, &_unitQuadIndices);
+
+    glBindVertexArray(_unitQuadArray);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _unitQuadVertices);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _unitQuadIndices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // Position attribute
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)nullptr);
+    glEnableVertexAttribArray(0);
+    // Texture coordinate attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
 void RenderWindow::setKeyCallback(void (*function)(GLFWwindow *, int, int, int, int)) {
     glfwSetKeyCallback(_window, function);
 }
@@ -100,22 +155,54 @@ bool RenderWindow::shouldClose() {
     return glfwWindowShouldClose(_window);
 }
 
-void RenderWindow::setShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
-    _shaderProgram = glCreateProgram();
-    glAttachShader(_shaderProgram, vertexShader);
-    glAttachShader(_shaderProgram, fragmentShader);
-    glLinkProgram(_shaderProgram);
+static GLuint linkShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
 
     GLint success;
-    glGetProgramiv(_shaderProgram, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if(!success) {
         GLchar infoLog[1024];
-        glGetProgramInfoLog(_shaderProgram, 1024, nullptr, infoLog);
+        glGetProgramInfoLog(program, 1024, nullptr, infoLog);
         spdlog::error("Failed to link shader program: {}", infoLog);
     }
+    return program;
+}
+
+void RenderWindow::setShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
+    _shaderProgram = linkShaderProgram(vertexShader, fragmentShader);
+    _spriteBatch.setProgram(_shaderProgram);
+}
+
+void RenderWindow::setPaletteShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
+    _paletteProgram = linkShaderProgram(vertexShader, fragmentShader);
+}
+
+void RenderWindow::setSpriteShaderProgram(GLuint vertexShader, GLuint fragmentShader) {
+    _spriteProgram = linkShaderProgram(vertexShader, fragmentShader);
+    _instancedSprites.setProgram(_spriteProgram);
+}
+
+void RenderWindow::setPalette(const float *rgba, int count) {
+    if(count > MaxPaletteSize) {
+        spdlog::warn("Palette of {} colours truncated to {}", count, MaxPaletteSize);
+        count = MaxPaletteSize;
+    }
+    _palette.assign(rgba, rgba + count * 4);
+}
+
+void RenderWindow::updateAspectRatio() {
+    // A server round trip on X11, so only done once per frame
+    int framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(_window, &framebufferWidth, &framebufferHeight);
+    if(framebufferWidth > 0 && framebufferHeight > 0)
+        _aspectRatio = (float)framebufferWidth / (float)framebufferHeight;
 }
 
 void RenderWindow::clear() {
+    updateAspectRatio();
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
@@ -216,48 +303,81 @@ void RenderWindow::drawTexture(float x, float y, float width, float height, stru
 }
 
 void RenderWindow::drawTexture(float x, float y, float scale, struct Texture texture, bool cleanup) {
-    float width, height;
-    float aspectRatio = (float)texture.width / (float)texture.height;
-    float windowAspectRatio = (float)_width / (float)_height;
-    width = scale;
-    height = scale / aspectRatio * windowAspectRatio;
+    auto [width, height] = scaledSize(scale, texture, _aspectRatio);
     drawTexture(x, y, width, height, texture, cleanup);
 }
 
-void RenderWindow::createBackgroundTextureBuffer(int width, int height){
-    _width = width;
-    _height = height;
+std::pair<float, float> RenderWindow::scaledSize(float scale, const struct Texture &texture, float aspectRatio) {
+    float textureAspectRatio = (float)texture.width / (float)texture.height;
+    return {scale, scale / textureAspectRatio * aspectRatio};
+}
+
+void RenderWindow::createBackgroundTextureBuffer(int width, int height, bool palette){
+    _backgroundWidth = width;
+    _backgroundHeight = height;
+    _paletteBackground = palette;
+    if(_paletteBackground && !_paletteProgram) {
+        spdlog::warn("No palette shader program set, using an RGBA background");
+        _paletteBackground = false;
+    }
+
     glGenTextures(1, &_backgroundTexture);
     glBindTexture(GL_TEXTURE_2D, _backgroundTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if(_paletteBackground) {
+        // Integer textures cannot be filtered, and blending indices makes no sense anyway
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    glGenBuffers(1, &_pbo);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, width * height * 4, nullptr, GL_STREAM_DRAW);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _pbo.create(GL_PIXEL_UNPACK_BUFFER, static_cast<size_t>(width) * height * (_paletteBackground ? 1 : 4));
 }
 
 GLubyte *RenderWindow::mapPBO() {
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
-    GLubyte *ptr = (GLubyte *)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-    return ptr;
+    return _pbo.map();
 }
 
 void RenderWindow::unmapPBO() {
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
-    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _pbo.unmap();
 }
 
 void RenderWindow::updateTextureFromPBO() {
     glBindTexture(GL_TEXTURE_2D, _backgroundTexture);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo.id());
+    // Rows of single byte pixels are not padded to four bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _backgroundWidth, _backgroundHeight, _paletteBackground ? GL_RED_INTEGER : GL_RGBA, GL_UNSIGNED_BYTE,
+                    (void *)_pbo.offset());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    _pbo.advance();
+}
+
+void RenderWindow::updateTextureFromPBO(const std::vector<Rect> &rects) {
+    if(rects.empty())
+        return;
+    glBindTexture(GL_TEXTURE_2D, _backgroundTexture);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo.id());
+    const GLenum format = _paletteBackground ? GL_RED_INTEGER : GL_RGBA;
+    const size_t pixelSize = _paletteBackground ? 1 : 4;
+    // Rows of a rect are _backgroundWidth pixels apart in the PBO
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, _backgroundWidth);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(const Rect &rect: rects) {
+        const size_t offset = _pbo.offset() + (static_cast<size_t>(rect.y) * _backgroundWidth + rect.x) * pixelSize;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, format, GL_UNSIGNED_BYTE, (void *)offset);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
+    _pbo.advance();
 }
 
 void RenderWindow::drawBackground() {
@@ -293,7 +413,14 @@ void RenderWindow::drawBackground() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    glUseProgram(_shaderProgram);
+    if(_paletteBackground) {
+        glUseProgram(_paletteProgram);
+        glUniform1i(glGetUniformLocation(_paletteProgram, "cells"), 0);
+        glUniform4fv(glGetUniformLocation(_paletteProgram, "palette"), static_cast<GLsizei>(_palette.size() / 4), _palette.data());
+        glUniform1i(glGetUniformLocation(_paletteProgram, "paletteSize"), static_cast<GLint>(_palette.size() / 4));
+    } else {
+        glUseProgram(_shaderProgram);
+    }
     glBindTexture(GL_TEXTURE_2D, _backgroundTexture);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
 
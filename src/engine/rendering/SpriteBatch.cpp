@@ -0,0 +1,118 @@
+#include "engine/rendering/SpriteBatch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <spdlog/spdlog.h>
+
+SpriteBatch::SpriteBatch()
+    : _program(0), _vertexArray(0), _indexBuffer(0), _capacity(0), _mapped(nullptr), _count(0), _drawCalls(0) {
+}
+
+void SpriteBatch::create(int capacity) {
+    discard();
+    _capacity = std::max(capacity, 1);
+    _vertices.create(GL_ARRAY_BUFFER, static_cast<size_t>(_capacity) * 4 * sizeof(SpriteVertex), false);
+
+    // Every quad uses the same two triangles, only the vertices move
+    std::vector<GLuint> indices(static_cast<size_t>(_capacity) * 6);
+    for(GLuint sprite = 0; sprite < static_cast<GLuint>(_capacity); ++sprite) {
+        GLuint *quad = indices.data() + sprite * 6;
+        GLuint vertex = sprite * 4;
+        quad[0] = vertex + 0; // top right
+        quad[1] = vertex + 1; // bottom right
+        quad[2] = vertex + 3; // top left
+        quad[3] = vertex + 1;
+        quad[4] = vertex + 2; // bottom left
+        quad[5] = vertex + 3;
+    }
+
+    glGenVertexArrays(1, &_vertexArray);
+    glGenBuffers(1, &_indexBuffer);
+    glBindVertexArray(_vertexArray);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vertices.id());
+    // Position attribute
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, x));
+    glEnableVertexAttribArray(0);
+    // Texture coordinate attribute
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *)offsetof(SpriteVertex, u));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void SpriteBatch::discard() {
+    if(!_vertexArray)
+        return;
+    _vertices.discard();
+    glDeleteBuffers(1, &_indexBuffer);
+    glDeleteVertexArrays(1, &_vertexArray);
+    _indexBuffer = 0;
+    _vertexArray = 0;
+    _mapped = nullptr;
+}
+
+void SpriteBatch::map() {
+    _mapped = (SpriteVertex *)_vertices.map();
+    if(!_mapped)
+        spdlog::error("Failed to map sprite vertex buffer");
+    _count = 0;
+    _runs.clear();
+}
+
+void SpriteBatch::flush() {
+    _vertices.unmap();
+    _mapped = nullptr;
+    if(_count) {
+        // Indices count from the start of the buffer, the slice starts further in
+        const GLint baseVertex = static_cast<GLint>(_vertices.offset() / sizeof(SpriteVertex));
+        glUseProgram(_program);
+        glBindVertexArray(_vertexArray);
+        for(const Run &run: _runs) {
+            glBindTexture(GL_TEXTURE_2D, run.texture);
+            const uintptr_t firstIndex = static_cast<uintptr_t>(run.first) * 6 * sizeof(GLuint);
+            glDrawElementsBaseVertex(GL_TRIANGLES, run.count * 6, GL_UNSIGNED_INT, (void *)firstIndex, baseVertex);
+            ++_drawCalls;
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    _vertices.advance();
+}
+
+void SpriteBatch::begin() {
+    _drawCalls = 0;
+    map();
+}
+
+void SpriteBatch::submit(float x, float y, float width, float height, const Texture &texture, const UvRect &uv) {
+    if(_count == _capacity) {
+        flush();
+        map();
+    }
+    if(!_mapped)
+        return;
+
+    if(_runs.empty() || _runs.back().texture != texture.id)
+        _runs.push_back(Run{texture.id, _count, 0});
+    ++_runs.back().count;
+
+    // Same corners and texture coordinates as RenderWindow::drawTexture
+    SpriteVertex *quad = _mapped + static_cast<size_t>(_count) * 4;
+    quad[0] = SpriteVertex{x + width / 2, y - height / 2, uv.u1, uv.v1}; // top right
+    quad[1] = SpriteVertex{x + width / 2, y + height / 2, uv.u1, uv.v0}; // bottom right
+    quad[2] = SpriteVertex{x - width / 2, y + height / 2, uv.u0, uv.v0}; // bottom left
+    quad[3] = SpriteVertex{x - width / 2, y - height / 2, uv.u0, uv.v1}; // top left
+    ++_count;
+}
+
+void SpriteBatch::end() {
+    if(_mapped)
+        flush();
+}
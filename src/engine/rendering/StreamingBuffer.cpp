@@ -0,0 +1,99 @@
+#include "engine/rendering/StreamingBuffer.hpp"
+
+#include <spdlog/spdlog.h>
+
+// Longest single wait for a slice before logging, in nanoseconds
+static const GLuint64 FenceTimeout = 100000000;
+
+StreamingBuffer::StreamingBuffer()
+    : _target(GL_ARRAY_BUFFER), _buffer(0), _sliceSize(0), _persistent(false), _keepContents(true), _current(0), _mapped(nullptr), _fences{} {
+}
+
+void StreamingBuffer::create(GLenum target, size_t sliceSize, bool keepContents) {
+    discard();
+    _target = target;
+    _sliceSize = sliceSize;
+    _keepContents = keepContents;
+    _persistent = GLAD_GL_VERSION_4_4;
+    _current = 0;
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(_target, _buffer);
+    if(_persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(_sliceSize * Slices);
+        glBufferStorage(_target, size, nullptr, flags);
+        _mapped = (GLubyte *)glMapBufferRange(_target, 0, size, flags);
+        if(!_mapped) {
+            spdlog::warn("Failed to map streaming buffer persistently, falling back to mapping every frame");
+            glDeleteBuffers(1, &_buffer);
+            glGenBuffers(1, &_buffer);
+            glBindBuffer(_target, _buffer);
+            _persistent = false;
+        }
+    }
+    if(!_persistent)
+        glBufferData(_target, static_cast<GLsizeiptr>(_sliceSize), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(_target, 0);
+    spdlog::debug("Created {} streaming buffer of {} bytes", _persistent ? "persistent" : "mapped", _sliceSize * slices());
+}
+
+void StreamingBuffer::discard() {
+    if(!_buffer)
+        return;
+    for(GLsync &fence: _fences) {
+        if(fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if(_mapped) {
+        glBindBuffer(_target, _buffer);
+        glUnmapBuffer(_target);
+        glBindBuffer(_target, 0);
+        _mapped = nullptr;
+    }
+    glDeleteBuffers(1, &_buffer);
+    _buffer = 0;
+}
+
+GLubyte *StreamingBuffer::map() {
+    if(!_persistent) {
+        glBindBuffer(_target, _buffer);
+        if(_keepContents)
+            return (GLubyte *)glMapBuffer(_target, GL_WRITE_ONLY);
+        // Invalidating lets the driver hand out fresh memory instead of waiting
+        // for draws still reading the old contents
+        return (GLubyte *)glMapBufferRange(_target, 0, static_cast<GLsizeiptr>(_sliceSize), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if(GLsync &fence = _fences[_current]) {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+        while(result == GL_TIMEOUT_EXPIRED) {
+            spdlog::warn("Still waiting for streaming buffer slice {}", _current);
+            result = glClientWaitSync(fence, 0, FenceTimeout);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+        if(result == GL_WAIT_FAILED)
+            return nullptr;
+    }
+    return _mapped + offset();
+}
+
+void StreamingBuffer::unmap() {
+    // Coherent writes are seen by every command issued after them
+    if(_persistent)
+        return;
+    glBindBuffer(_target, _buffer);
+    glUnmapBuffer(_target);
+    glBindBuffer(_target, 0);
+}
+
+void StreamingBuffer::advance() {
+    if(!_persistent)
+        return;
+    if(_fences[_current])
+        glDeleteSync(_fences[_current]);
+    _fences[_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _current = (_current + 1) % Slices;
+}
@@ -0,0 +1,50 @@
+#include "engine/simulation/FireBrush.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FireBrush::FireBrush(BrushShape shape, int radiusX, int radiusY)
+    : _radiusX(std::max(radiusX, 0)), _radiusY(std::max(radiusY, 0)) {
+    _halfWidths.resize(2 * _radiusY + 1, _radiusX);
+    if(shape != BrushShape::Circle || _radiusY == 0)
+        return;
+
+    // Ellipse through the ends of both radii
+    for(int dy = -_radiusY; dy <= _radiusY; ++dy) {
+        double v = static_cast<double>(dy) / _radiusY;
+        _halfWidths[dy + _radiusY] = static_cast<int>(std::floor(_radiusX * std::sqrt(1.0 - v * v) + 1e-9));
+    }
+}
+
+void FireStampBatch::clear() {
+    _spans.clear();
+    _merged = true;
+}
+
+void FireStampBatch::add(int x, int y, const FireBrush &brush) {
+    for(int dy = -brush.radiusY(); dy <= brush.radiusY(); ++dy) {
+        int halfWidth = brush.halfWidth(dy);
+        _spans.push_back(Span{y + dy, x - halfWidth, x + halfWidth + 1});
+    }
+    _merged = false;
+}
+
+const std::vector<FireStampBatch::Span> &FireStampBatch::spans() {
+    if(_merged)
+        return _spans;
+
+    std::sort(_spans.begin(), _spans.end(), [](const Span &a, const Span &b) {
+        return a.y != b.y ? a.y < b.y : a.x0 < b.x0;
+    });
+    size_t out = 0;
+    for(size_t i = 1; i < _spans.size(); ++i) {
+        Span &last = _spans[out];
+        if(_spans[i].y == last.y && _spans[i].x0 <= last.x1)
+            last.x1 = std::max(last.x1, _spans[i].x1);
+        else
+            _spans[++out] = _spans[i];
+    }
+    _spans.resize(_spans.empty() ? 0 : out + 1);
+    _merged = true;
+    return _spans;
+}
@@ -0,0 +1,101 @@
+#include "engine/simulation/FireDirtyRects.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void FireDirtyRects::setTargets(int count) {
+    count = std::clamp(count, 1, MaxTargets);
+    _targetMask = static_cast<uint8_t>((1u << count) - 1);
+    markAll();
+}
+
+void FireDirtyRects::markAll() {
+    std::fill(_dirty.begin(), _dirty.end(), _targetMask);
+    _anyDirty = _dirty.empty() ? 0 : _targetMask;
+}
+
+void FireDirtyRects::update(const FireGrid &grid) {
+    update(grid, Rect{0, 0, grid.width(), grid.height()});
+}
+
+void FireDirtyRects::update(const FireGrid &grid, const Rect &region) {
+    if(grid.width() != _shown.width() || grid.height() != _shown.height()) {
+        _shown.resize(grid.width(), grid.height());
+        std::memcpy(_shown.words(), grid.words(), grid.wordCount() * sizeof(uint64_t));
+        _tilesX = grid.wordsPerRow();
+        _tilesY = (grid.height() + TileHeight - 1) / TileHeight;
+        _dirty.assign(static_cast<size_t>(_tilesX) * _tilesY, 0);
+        markAll();
+        return;
+    }
+
+    const int wBegin = std::max(region.x, 0) / TileWidth;
+    const int wEnd = std::min((region.x + region.width + TileWidth - 1) / TileWidth, _tilesX);
+    const int yEnd = std::min(region.y + region.height, grid.height());
+    for(int y = std::max(region.y, 0); y < yEnd; ++y) {
+        const uint64_t *row = grid.row(y);
+        uint64_t *shown = _shown.row(y);
+        uint8_t *dirty = _dirty.data() + static_cast<size_t>(y / TileHeight) * _tilesX;
+        for(int w = wBegin; w < wEnd; ++w) {
+            if(row[w] != shown[w]) {
+                shown[w] = row[w];
+                dirty[w] = _targetMask;
+                _anyDirty = _targetMask;
+            }
+        }
+    }
+}
+
+void FireDirtyRects::clear(int target) {
+    if(empty(target))
+        return;
+    const uint8_t keep = static_cast<uint8_t>(~(1u << target));
+    for(uint8_t &dirty: _dirty)
+        dirty &= keep;
+    _anyDirty &= keep;
+}
+
+const std::vector<Rect> &FireDirtyRects::rects(int target) {
+    _rects.clear();
+    if(empty(target))
+        return _rects;
+    const uint8_t bit = static_cast<uint8_t>(1u << target);
+
+    // Rects that reach the tile row above, a span with the same columns below
+    // one of them grows it instead of starting a new rect. Both lists are
+    // sorted by column.
+    std::vector<size_t> open, next;
+    for(int ty = 0; ty < _tilesY; ++ty) {
+        const uint8_t *dirty = _dirty.data() + static_cast<size_t>(ty) * _tilesX;
+        const int y = ty * TileHeight;
+        const int height = std::min(y + TileHeight, _shown.height()) - y;
+        size_t above = 0;
+        next.clear();
+        for(int tx = 0; tx < _tilesX;) {
+            if(!(dirty[tx] & bit)) {
+                ++tx;
+                continue;
+            }
+            int end = tx + 1;
+            for(int scan = end; scan < _tilesX && scan - end <= MergeGap; ++scan) {
+                if(dirty[scan] & bit)
+                    end = scan + 1;
+            }
+            const int x = tx * TileWidth;
+            const int width = std::min(end * TileWidth, _shown.width()) - x;
+            tx = end;
+
+            while(above < open.size() && _rects[open[above]].x < x)
+                ++above;
+            if(above < open.size() && _rects[open[above]].x == x && _rects[open[above]].width == width) {
+                _rects[open[above]].height += height;
+                next.push_back(open[above]);
+            } else {
+                next.push_back(_rects.size());
+                _rects.push_back(Rect{x, y, width, height});
+            }
+        }
+        open.swap(next);
+    }
+    return _rects;
+}
@@ -0,0 +1,95 @@
+#include "engine/simulation/FireGrid.hpp"
+
+#include <algorithm>
+#include <bit>
+
+FireGrid::FireGrid() : _width(0), _height(0), _wordsPerRow(0) {
+}
+
+FireGrid::FireGrid(int width, int height) : FireGrid() {
+    resize(width, height);
+}
+
+void FireGrid::resize(int width, int height) {
+    _width = width;
+    _height = height;
+    _wordsPerRow = (width + 63) / 64;
+    _burning.assign(static_cast<size_t>(_wordsPerRow) * height, 0);
+}
+
+void FireGrid::clear() {
+    std::fill(_burning.begin(), _burning.end(), 0);
+}
+
+uint64_t FireGrid::lastWordMask() const {
+    int used = _width % 64;
+    return used ? (uint64_t(1) << used) - 1 : ~uint64_t(0);
+}
+
+bool FireGrid::isBurning(int x, int y) const {
+    return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+bool FireGrid::ignite(int x, int y) {
+    uint64_t &word = row(y)[x >> 6];
+    uint64_t bit = uint64_t(1) << (x & 63);
+    bool changed = !(word & bit);
+    word |= bit;
+    return changed;
+}
+
+bool FireGrid::extinguish(int x, int y) {
+    uint64_t &word = row(y)[x >> 6];
+    uint64_t bit = uint64_t(1) << (x & 63);
+    bool changed = word & bit;
+    word &= ~bit;
+    return changed;
+}
+
+size_t FireGrid::burningCount() const {
+    size_t count = 0;
+    for(uint64_t word: _burning)
+        count += std::popcount(word);
+    return count;
+}
+
+void colorizeFireGrid(const FireGrid &grid, unsigned char *rgba) {
+    colorizeFireGrid(grid, rgba, Rect{0, 0, grid.width(), grid.height()});
+}
+
+void colorizeFireGrid(const FireGrid &grid, unsigned char *rgba, const Rect &rect) {
+    for(int y = rect.y; y < rect.y + rect.height; ++y) {
+        const uint64_t *row = grid.row(y);
+        unsigned char *pixel = rgba + (static_cast<size_t>(y) * grid.width() + rect.x) * 4;
+        for(int x = rect.x; x < rect.x + rect.width; ++x, pixel += 4) {
+            if((row[x >> 6] >> (x & 63)) & 1) {
+                pixel[0] = 255; // R
+                pixel[1] = 0;   // G
+                pixel[2] = 0;   // B
+            } else {
+                pixel[0] = 90;  // R
+                pixel[1] = 255; // G
+                pixel[2] = 90;  // B
+            }
+            pixel[3] = 255;     // A
+        }
+    }
+}
+
+void indexFireGrid(const FireGrid &grid, const FireGrid *burned, uint8_t *cells, const Rect &rect) {
+    const uint8_t forest = static_cast<uint8_t>(FireCellState::Forest);
+    const uint8_t burning = static_cast<uint8_t>(FireCellState::Burning);
+    const uint8_t extinguished = static_cast<uint8_t>(FireCellState::Extinguished);
+    for(int y = rect.y; y < rect.y + rect.height; ++y) {
+        const uint64_t *row = grid.row(y);
+        const uint64_t *burnedRow = burned ? burned->row(y) : nullptr;
+        uint8_t *cell = cells + static_cast<size_t>(y) * grid.width() + rect.x;
+        for(int x = rect.x; x < rect.x + rect.width; ++x, ++cell) {
+            const uint64_t bit = uint64_t(1) << (x & 63);
+            if(row[x >> 6] & bit)
+                *cell = burning;
+            else
+                *cell = burnedRow && (burnedRow[x >> 6] & bit) ? extinguished : forest;
+        }
+    }
+}
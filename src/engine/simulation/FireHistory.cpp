@@ -0,0 +1,160 @@
+#include "engine/simulation/FireHistory.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static void writeVarint(std::vector<uint8_t> &data, size_t value) {
+    while(value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+static size_t readVarint(const uint8_t *&data) {
+    size_t value = 0;
+    for(int shift = 0;; shift += 7) {
+        uint8_t byte = *data++;
+        value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return value;
+    }
+}
+
+FireHistory::FireHistory(size_t capacity, int keyframeInterval)
+    : _capacity(std::max<size_t>(capacity, 1)), _keyframeInterval(std::max(keyframeInterval, 1)), _width(0), _height(0),
+      _records(_capacity), _first(0), _count(0), _sinceKeyframe(0) {}
+
+void FireHistory::clear() {
+    for(Record &record: _records)
+        record.data.clear();
+    _first = 0;
+    _count = 0;
+    _sinceKeyframe = 0;
+}
+
+void FireHistory::encode(const FireGrid &grid, const FireGrid *base, std::vector<uint8_t> &data) {
+    data.clear();
+    const uint64_t *words = grid.words();
+    const uint64_t *baseWords = base ? base->words() : nullptr;
+    const size_t wordCount = grid.wordCount();
+    auto delta = [&](size_t i) { return baseWords ? words[i] ^ baseWords[i] : words[i]; };
+
+    size_t i = 0;
+    while(i < wordCount) {
+        size_t zeroes = i;
+        while(i < wordCount && !delta(i))
+            ++i;
+        zeroes = i - zeroes;
+        size_t changed = i;
+        while(i < wordCount && delta(i))
+            ++i;
+        changed = i - changed;
+
+        writeVarint(data, zeroes);
+        writeVarint(data, changed);
+        for(size_t j = i - changed; j < i; ++j) {
+            uint64_t word = delta(j);
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&word);
+            data.insert(data.end(), bytes, bytes + sizeof(word));
+        }
+    }
+}
+
+void FireHistory::apply(const std::vector<uint8_t> &data, FireGrid &grid) {
+    uint64_t *words = grid.words();
+    const uint8_t *in = data.data();
+    const uint8_t *end = in + data.size();
+    size_t i = 0;
+    while(in < end) {
+        i += readVarint(in);
+        size_t changed = readVarint(in);
+        for(; changed; --changed, ++i, in += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, in, sizeof(word));
+            words[i] ^= word;
+        }
+    }
+}
+
+size_t FireHistory::find(uint64_t generation) const {
+    size_t low = 0;
+    size_t high = _count;
+    while(low < high) {
+        size_t mid = (low + high) / 2;
+        if(at(mid).generation < generation)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low < _count && at(low).generation == generation ? low : _count;
+}
+
+void FireHistory::dropOldest() {
+    // The next record loses the keyframe it is decoded from, so it becomes one itself
+    const bool promote = _count > 1 && !at(1).keyframe;
+    if(promote)
+        restore(at(1).generation, _scratch);
+
+    at(0).data.clear();
+    _first = (_first + 1) % _capacity;
+    --_count;
+    if(!promote)
+        return;
+
+    Record &oldest = at(0);
+    encode(_scratch, nullptr, oldest.data);
+    oldest.keyframe = true;
+    _sinceKeyframe = 0;
+    for(size_t i = _count; i-- > 0;) {
+        ++_sinceKeyframe;
+        if(at(i).keyframe)
+            break;
+    }
+}
+
+void FireHistory::record(const FireGrid &grid, uint64_t generation) {
+    if(grid.width() != _width || grid.height() != _height) {
+        clear();
+        _width = grid.width();
+        _height = grid.height();
+        _last.resize(_width, _height);
+        _scratch.resize(_width, _height);
+    }
+    if(_count && generation <= newestGeneration())
+        return;
+    if(_count == _capacity)
+        dropOldest();
+
+    Record &added = at(_count);
+    added.generation = generation;
+    added.keyframe = _count == 0 || _sinceKeyframe >= _keyframeInterval;
+    encode(grid, added.keyframe ? nullptr : &_last, added.data);
+    ++_count;
+    _sinceKeyframe = added.keyframe ? 1 : _sinceKeyframe + 1;
+    std::memcpy(_last.words(), grid.words(), grid.wordCount() * sizeof(uint64_t));
+}
+
+bool FireHistory::restore(uint64_t generation, FireGrid &grid) const {
+    size_t index = find(generation);
+    if(index == _count)
+        return false;
+    size_t keyframe = index;
+    while(!at(keyframe).keyframe)
+        --keyframe;
+
+    if(grid.width() != _width || grid.height() != _height)
+        grid.resize(_width, _height);
+    else
+        grid.clear();
+    for(size_t i = keyframe; i <= index; ++i)
+        apply(at(i).data, grid);
+    return true;
+}
+
+size_t FireHistory::memoryBytes() const {
+    size_t bytes = 0;
+    for(size_t i = 0; i < _count; ++i)
+        bytes += at(i).data.size();
+    return bytes;
+}
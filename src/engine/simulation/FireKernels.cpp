@@ -0,0 +1,105 @@
+#include "engine/simulation/FireKernels.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "engine/simulation/FireSimulation.hpp"
+
+// Bits of candidates whose roll hash32(cell ^ key) falls below the limit, cell
+// being firstCell plus the bit index. The limit is threshold, or with levels
+// levels[bit] times threshold.
+static inline uint64_t rollBits(uint64_t candidates, uint32_t firstCell, uint32_t key, uint32_t threshold, const uint8_t *levels) {
+    uint64_t hits = 0;
+    while(candidates) {
+        int bit = std::countr_zero(candidates);
+        candidates &= candidates - 1;
+        uint32_t limit = levels ? levels[bit] * threshold : threshold;
+        if(CounterRng::hash32((firstCell + bit) ^ key) < limit)
+            hits |= uint64_t(1) << bit;
+    }
+    return hits;
+}
+
+// Word-at-a-time kernel. Neighbour masks for a whole word are built with
+// shifts, and only the candidate cells are rolled to decide which of them
+// actually catch fire from the given direction. levels points at the
+// flammability of the 64 cells of the word, or is null when every cell shares
+// the threshold.
+static void stepRowScalar(const FireStepContext &ctx, int y, int wordBegin, int wordEnd) {
+    const FireGrid &src = *ctx.src;
+    const int wordsPerRow = src.wordsPerRow();
+    const uint64_t *row = src.row(y);
+    const uint64_t *above = y > 0 ? src.row(y - 1) : nullptr;
+    const uint64_t *below = y + 1 < src.height() ? src.row(y + 1) : nullptr;
+    const uint64_t lastWordMask = src.lastWordMask();
+    const uint32_t rowCell = static_cast<uint32_t>(y) * static_cast<uint32_t>(src.width());
+    const uint8_t *rowLevels = ctx.flammability ? ctx.flammability + static_cast<size_t>(y) * ctx.flammabilityStride : nullptr;
+    uint64_t *out = ctx.dst->row(y);
+
+    for(int w = wordBegin; w < wordEnd; ++w) {
+        const uint64_t current = row[w];
+
+        // Bit x of each mask is set when the neighbour of cell x in that direction burns
+        uint64_t sources[4];
+        sources[FireSimulation::FromLeft] = (current << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+        sources[FireSimulation::FromRight] = (current >> 1) | (w + 1 < wordsPerRow ? row[w + 1] << 63 : 0);
+        sources[FireSimulation::FromAbove] = above ? above[w] : 0;
+        sources[FireSimulation::FromBelow] = below ? below[w] : 0;
+
+        const uint64_t fuel = ~current & (w == wordsPerRow - 1 ? lastWordMask : ~uint64_t(0));
+        const uint32_t firstCell = rowCell + static_cast<uint32_t>(w) * 64;
+        const uint8_t *levels = rowLevels ? rowLevels + static_cast<size_t>(w) * 64 : nullptr;
+
+        uint64_t ignited = 0;
+        for(int dir = 0; dir < 4; ++dir) {
+            uint64_t candidates = sources[dir] & fuel & ~ignited;
+            if(candidates)
+                ignited |= rollBits(candidates, firstCell, ctx.streamKeys[dir], ctx.thresholds[dir], levels);
+        }
+        out[w] = current | ignited;
+    }
+}
+
+// Cell-by-cell kernel that mirrors the original per-pixel loop
+static void stepRowReference(const FireStepContext &ctx, int y, int wordBegin, int wordEnd) {
+    const FireGrid &src = *ctx.src;
+    const int width = src.width();
+    const int height = src.height();
+    const int xEnd = std::min(wordEnd * 64, width);
+
+    auto rolls = [&](int x, int dir) {
+        uint32_t cell = static_cast<uint32_t>(y) * static_cast<uint32_t>(width) + static_cast<uint32_t>(x);
+        uint32_t limit = ctx.thresholds[dir];
+        if(ctx.flammability)
+            limit *= ctx.flammability[static_cast<size_t>(y) * ctx.flammabilityStride + x];
+        return CounterRng::hash32(cell ^ ctx.streamKeys[dir]) < limit;
+    };
+
+    uint64_t *out = ctx.dst->row(y);
+    for(int w = wordBegin; w < wordEnd; ++w)
+        out[w] = 0;
+
+    for(int x = wordBegin * 64; x < xEnd; ++x) {
+        bool burning = src.isBurning(x, y) ||
+                       (x > 0 && src.isBurning(x - 1, y) && rolls(x, FireSimulation::FromLeft)) ||
+                       (x < width - 1 && src.isBurning(x + 1, y) && rolls(x, FireSimulation::FromRight)) ||
+                       (y > 0 && src.isBurning(x, y - 1) && rolls(x, FireSimulation::FromAbove)) ||
+                       (y < height - 1 && src.isBurning(x, y + 1) && rolls(x, FireSimulation::FromBelow));
+        if(burning)
+            out[x >> 6] |= uint64_t(1) << (x & 63);
+    }
+}
+
+const char *fireKernelName(FireKernel kernel) {
+    switch(kernel) {
+    case FireKernel::Reference:
+        return "reference";
+    case FireKernel::Scalar:
+        return "scalar";
+    }
+    return "unknown";
+}
+
+FireRowKernel fireRowKernel(FireKernel kernel) {
+    return kernel == FireKernel::Reference ? stepRowReference : stepRowScalar;
+}
@@ -0,0 +1,31 @@
+#include "engine/simulation/FireOccupancy.hpp"
+
+FireOccupancy::FireOccupancy() : _tilesX(0), _tilesY(0) {
+}
+
+void FireOccupancy::resize(int width, int height) {
+    _tilesX = (width + 63) / 64;
+    _tilesY = (height + TileSize - 1) / TileSize;
+    _rows.assign(static_cast<size_t>(_tilesX) * _tilesY, 0);
+}
+
+void FireOccupancy::rebuild(const FireGrid &grid) {
+    resize(grid.width(), grid.height());
+    for(int y = 0; y < grid.height(); ++y) {
+        const uint64_t *row = grid.row(y);
+        const int tileRow = (y / TileSize) * _tilesX;
+        const uint64_t bit = uint64_t(1) << (y % TileSize);
+        for(int w = 0; w < _tilesX; ++w) {
+            if(row[w])
+                _rows[tileRow + w] |= bit;
+        }
+    }
+}
+
+void FireOccupancy::updateRow(int tile, int row, uint64_t word) {
+    const uint64_t bit = uint64_t(1) << row;
+    if(word)
+        _rows[tile] |= bit;
+    else
+        _rows[tile] &= ~bit;
+}
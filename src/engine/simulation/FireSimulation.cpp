@@ -0,0 +1,744 @@
+#include "engine/simulation/FireSimulation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <span>
+#include <utility>
+
+#include "engine/core/Random.hpp"
+#include "engine/core/WorkerPool.hpp"
+#include "engine/simulation/ForestCells.hpp"
+
+FireSimulation::FireSimulation(int width, int height, float spreadChance, uint64_t seed)
+    : _front(width, height), _back(width, height), _forest(nullptr), _wind(width, height), _mode(FireStepMode::Dense), _workers(nullptr),
+      _seed(seed), _generation(0), _time(0.0), _chunksX((width + TileSize - 1) / TileSize),
+      _chunksY((height + TileSize - 1) / TileSize), _sleepingChunks(true), _stepInProgress(false), _sliceCursor(0) {
+    setSpreadChance(spreadChance);
+    setKernel(FireKernel::Scalar);
+    updateStreamKeys();
+    _chunkFlags.assign(static_cast<size_t>(_chunksX) * _chunksY, 0);
+    _burned.resize(width, height);
+    _statistics.resize(width, height);
+    wakeAll();
+}
+
+void FireSimulation::setKernel(FireKernel kernel) {
+    _kernel = kernel;
+    _rowKernel = fireRowKernel(_kernel);
+}
+
+void FireSimulation::setSpreadChance(float chance) {
+    _spreadChance = chance;
+    updateThresholds();
+}
+
+void FireSimulation::setForest(const ForestCells *forest) {
+    _forest = forest;
+    updateThresholds();
+}
+
+void FireSimulation::updateThresholds() {
+    // Without a forest the limit is chance * 2^32. With one, flammability 128
+    // spreads at the base chance and the scale is capped so that 255 times it
+    // still fits in 32 bits.
+    const double base = _forest ? 33554432.0 : 4294967296.0;
+    const double limit = _forest ? UINT32_MAX / 255.0 : UINT32_MAX;
+    _thresholds.resize(WindField::BucketCount * 4);
+    for(int bucket = 0; bucket < WindField::BucketCount; ++bucket) {
+        for(int dir = 0; dir < 4; ++dir) {
+            double factor = WindField::spreadFactor(static_cast<uint8_t>(bucket), TravelX[dir], TravelY[dir]);
+            double threshold = std::clamp(_spreadChance * factor * base, 0.0, limit);
+            _thresholds[bucket * 4 + dir] = static_cast<uint32_t>(threshold);
+        }
+    }
+}
+
+void FireSimulation::setSeed(uint64_t seed) {
+    _seed = seed;
+    updateStreamKeys();
+}
+
+void FireSimulation::setGeneration(uint64_t generation) {
+    if(_stepInProgress)
+        continueStep(1.0f);
+    _generation = generation;
+    _time = static_cast<double>(generation);
+    updateStreamKeys();
+    if(_mode == FireStepMode::Event)
+        rebuildEvents();
+}
+
+void FireSimulation::updateStreamKeys() {
+    CounterRng generation = CounterRng(_seed).derive(_generation);
+    for(int dir = 0; dir < 4; ++dir)
+        _streamKeys[dir] = generation.derive(dir).key32();
+}
+
+uint32_t FireSimulation::spreadLimit(int x, int y, Direction dir) const {
+    uint32_t limit = _thresholds[_wind.cellBucket(x, y) * 4 + dir];
+    if(_forest)
+        limit *= _forest->flammability(x, y);
+    return limit;
+}
+
+bool FireSimulation::spreads(int x, int y, Direction dir) const {
+    uint32_t cell = static_cast<uint32_t>(y) * static_cast<uint32_t>(_front.width()) + static_cast<uint32_t>(x);
+    return CounterRng::hash32(cell ^ _streamKeys[dir]) < spreadLimit(x, y, dir);
+}
+
+void FireSimulation::step() {
+    if(_stepInProgress) {
+        continueStep(1.0f);
+        return;
+    }
+    if(_mode == FireStepMode::Event) {
+        advance(1.0);
+        return;
+    }
+
+    if(_mode == FireStepMode::Frontier) {
+        stepFrontier();
+    } else {
+        beginChunkStep();
+        stepChunkRange(0, _awakeChunks.size());
+        finishChunkStep();
+    }
+    finishGeneration();
+}
+
+bool FireSimulation::beginStep() {
+    if(_stepInProgress)
+        return false;
+    if(_mode != FireStepMode::Dense && _mode != FireStepMode::Tiled) {
+        step();
+        return true;
+    }
+    beginChunkStep();
+    _stepInProgress = true;
+    _sliceCursor = 0;
+    return false;
+}
+
+bool FireSimulation::continueStep(float fraction) {
+    if(!_stepInProgress)
+        return false;
+
+    const size_t total = _awakeChunks.size();
+    const size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(fraction * total)));
+    const size_t end = std::min(_sliceCursor + count, total);
+    stepChunkRange(_sliceCursor, end);
+    _sliceCursor = end;
+    if(_sliceCursor < total)
+        return false;
+
+    finishChunkStep();
+    finishGeneration();
+    _stepInProgress = false;
+
+    // Edits made during the step apply to the generation just published
+    std::vector<FireEdit> edits;
+    std::swap(edits, _deferredEdits);
+    for(const FireEdit &edit: edits) {
+        if(edit.ignite)
+            ignite(edit.x, edit.y);
+        else
+            extinguishRect(edit.x, edit.y, edit.width, edit.height);
+    }
+    return true;
+}
+
+void FireSimulation::finishGeneration() {
+    ++_generation;
+    _time = static_cast<double>(_generation);
+    updateStreamKeys();
+}
+
+size_t FireSimulation::advance(double generations) {
+    const double end = _time + generations;
+    if(_mode != FireStepMode::Event) {
+        size_t steps = 0;
+        for(; static_cast<double>(_generation + 1) <= end; ++steps)
+            step();
+        _time = end;
+        return steps;
+    }
+
+    const int width = _front.width();
+    size_t ignited = 0;
+    while(!_events.empty() && _events.top().time <= end) {
+        FireEvent event = _events.top();
+        _events.pop();
+        const int x = static_cast<int>(event.target % width);
+        const int y = static_cast<int>(event.target / width);
+        // The source may have been put out after the event was scheduled
+        if(!_front.isBurning(static_cast<int>(event.source % width), static_cast<int>(event.source / width)))
+            continue;
+        if(igniteCell(x, y)) {
+            scheduleNeighbours(x, y, event.time);
+            ++ignited;
+        }
+    }
+
+    _time = end;
+    const uint64_t generation = static_cast<uint64_t>(end);
+    if(generation != _generation) {
+        _generation = generation;
+        updateStreamKeys();
+    }
+    return ignited;
+}
+
+void FireSimulation::scheduleSpread(int sourceX, int sourceY, Direction dir, double start) {
+    const int x = sourceX + TravelX[dir];
+    const int y = sourceY + TravelY[dir];
+    if(x < 0 || x >= _front.width() || y < 0 || y >= _front.height() || _front.isBurning(x, y))
+        return;
+    const uint32_t limit = spreadLimit(x, y, dir);
+    if(limit == 0)
+        return;
+
+    // A roll that succeeds with chance p every generation first succeeds after
+    // 1 / p generations on average. The event delay keeps that mean: half a
+    // generation, the continuous counterpart of waiting for the next step,
+    // plus an exponential wait. The draw only depends on the seed, the start
+    // time and the target, so the outcome does not depend on how time is
+    // split into advance calls.
+    const double chance = limit / 4294967296.0;
+    const double rate = chance < 1.0 ? 1.0 / (1.0 / chance - 0.5) : 1e9;
+    const uint32_t target = static_cast<uint32_t>(y) * static_cast<uint32_t>(_front.width()) + static_cast<uint32_t>(x);
+    const CounterRng rng = CounterRng(_seed).derive(std::bit_cast<uint64_t>(start));
+    const double delay = 0.5 - std::log1p(-static_cast<double>(rng.uniform(static_cast<uint64_t>(target) * 4 + dir))) / rate;
+    const uint32_t source = static_cast<uint32_t>(sourceY) * static_cast<uint32_t>(_front.width()) + static_cast<uint32_t>(sourceX);
+    _events.push(FireEvent{start + delay, target, source});
+}
+
+void FireSimulation::scheduleNeighbours(int x, int y, double start) {
+    for(int dir = 0; dir < 4; ++dir)
+        scheduleSpread(x, y, static_cast<Direction>(dir), start);
+}
+
+void FireSimulation::rebuildEvents() {
+    _events = {};
+    for(int y = 0; y < _front.height(); ++y) {
+        const uint64_t *row = _front.row(y);
+        for(int w = 0; w < _front.wordsPerRow(); ++w) {
+            for(uint64_t burning = row[w]; burning; burning &= burning - 1)
+                scheduleNeighbours(w * 64 + std::countr_zero(burning), y, _time);
+        }
+    }
+}
+
+void FireSimulation::cellExtinguished(int x, int y) {
+    if(_mode == FireStepMode::Frontier) {
+        // Neighbours that were fully enclosed by fire have fuel again
+        pushBurningNeighbours(x, y);
+    } else if(_mode == FireStepMode::Event) {
+        // Burning neighbours already spent their event on this cell
+        for(int dir = 0; dir < 4; ++dir) {
+            int sourceX = x - TravelX[dir];
+            int sourceY = y - TravelY[dir];
+            if(sourceX >= 0 && sourceX < _front.width() && sourceY >= 0 && sourceY < _front.height() &&
+               _front.isBurning(sourceX, sourceY))
+                scheduleSpread(sourceX, sourceY, static_cast<Direction>(dir), _time);
+        }
+    }
+}
+
+FireStepContext FireSimulation::stepContext() {
+    // Thresholds are filled in per chunk from its wind bucket
+    if(_forest)
+        return FireStepContext{&_front, &_back, _streamKeys, nullptr, _forest->flammability(), _forest->stride()};
+    return FireStepContext{&_front, &_back, _streamKeys, nullptr, nullptr, 0};
+}
+
+void FireSimulation::stepFrontier() {
+    const int width = _front.width();
+    const int height = _front.height();
+
+    // From here on _inFrontier marks membership of the next frontier
+    for(uint32_t cell: _frontier)
+        _inFrontier.extinguish(static_cast<int>(cell % width), static_cast<int>(cell / width));
+
+    // Ignitions are only collected here and applied afterwards, so every roll
+    // sees the grid exactly as the dense kernels do
+    _nextFrontier.clear();
+    _ignitions.clear();
+    for(uint32_t cell: _frontier) {
+        int x = static_cast<int>(cell % width);
+        int y = static_cast<int>(cell / width);
+        // Entries of extinguished cells are stale
+        if(!_front.isBurning(x, y))
+            continue;
+
+        const struct {
+            int x, y;
+            Direction dir;
+        } neighbours[4] = {{x + 1, y, FromLeft}, {x - 1, y, FromRight}, {x, y + 1, FromAbove}, {x, y - 1, FromBelow}};
+        bool hasFuel = false;
+        for(auto [nx, ny, dir]: neighbours) {
+            if(nx < 0 || nx >= width || ny < 0 || ny >= height || _front.isBurning(nx, ny))
+                continue;
+            if(spreads(nx, ny, dir)) {
+                if(_inFrontier.ignite(nx, ny)) {
+                    _ignitions.push_back(static_cast<uint32_t>(ny) * width + nx);
+                    _nextFrontier.push_back(_ignitions.back());
+                }
+            } else {
+                hasFuel = true;
+            }
+        }
+
+        if(hasFuel && _inFrontier.ignite(x, y))
+            _nextFrontier.push_back(cell);
+    }
+
+    for(uint32_t cell: _ignitions)
+        igniteCell(static_cast<int>(cell % width), static_cast<int>(cell / width));
+    std::swap(_frontier, _nextFrontier);
+}
+
+void FireSimulation::forEachChunk(std::span<const int> chunks, const std::function<void(int)> &job) {
+    if(_mode == FireStepMode::Tiled && _workers) {
+        _workers->parallelFor(static_cast<int>(chunks.size()), [&](int i) { job(chunks[i]); });
+    } else {
+        for(int chunk: chunks)
+            job(chunk);
+    }
+}
+
+void FireSimulation::beginChunkStep() {
+    // Sleeping chunks are not written by the kernel, so the back grid has to
+    // catch up with any change made to them since the last swap
+    forEachChunk(_staleChunks, [&](int chunk) {
+        if(!(_chunkFlags[chunk] & ChunkAwake)) {
+            const int chunkX = chunk % _chunksX;
+            const int yBegin = (chunk / _chunksX) * TileSize;
+            const int yEnd = std::min(yBegin + TileSize, _front.height());
+            for(int y = yBegin; y < yEnd; ++y)
+                _back.row(y)[chunkX] = _front.row(y)[chunkX];
+            _backOccupancy.setRows(chunk, _occupancy.rows(chunk));
+        }
+    });
+    for(int chunk: _staleChunks)
+        _chunkFlags[chunk] &= ~ChunkStale;
+    _staleChunks.clear();
+}
+
+void FireSimulation::stepChunkRange(size_t begin, size_t end) {
+    const FireStepContext ctx = stepContext();
+    forEachChunk(std::span<const int>(_awakeChunks).subspan(begin, end - begin), [&](int chunk) { stepChunk(ctx, chunk); });
+}
+
+void FireSimulation::finishChunkStep() {
+    std::swap(_front, _back);
+    std::swap(_occupancy, _backOccupancy);
+
+    // Only awake chunks and the neighbours of chunks that caught fire can have
+    // gained or lost cells that are about to burn
+    _classifyChunks.clear();
+    auto queue = [&](int chunk, uint8_t flags) {
+        if(!(_chunkFlags[chunk] & ChunkQueued))
+            _classifyChunks.push_back(chunk);
+        _chunkFlags[chunk] |= ChunkQueued | flags;
+    };
+    for(int chunk: _awakeChunks) {
+        queue(chunk, 0);
+        if(!(_chunkFlags[chunk] & ChunkChanged))
+            continue;
+        setChunkFlag(chunk, ChunkStale, _staleChunks);
+        setChunkFlag(chunk, ChunkDirty, _dirtyChunks);
+        // The perimeter of a chunk reaches into its right and lower neighbours
+        const int chunkX = chunk % _chunksX;
+        const int chunkY = chunk / _chunksX;
+        queue(chunk, ChunkRecount);
+        if(chunkX > 0)
+            queue(chunk - 1, ChunkRecount);
+        if(chunkX + 1 < _chunksX)
+            queue(chunk + 1, 0);
+        if(chunkY > 0)
+            queue(chunk - _chunksX, ChunkRecount);
+        if(chunkY + 1 < _chunksY)
+            queue(chunk + _chunksX, 0);
+    }
+
+    forEachChunk(_classifyChunks, [&](int chunk) {
+        // Chunks that were stepped already have their counts pending
+        const uint8_t flags = _chunkFlags[chunk];
+        if(flags & ChunkRecount) {
+            FireTileStats stats = flags & ChunkAwake ? _statistics.pending(chunk) : _statistics.tile(chunk);
+            stats.perimeter = FireStatistics::countPerimeter(_front, chunk, chunkRowsOwningEdges(chunk));
+            _statistics.setPending(chunk, stats);
+        } else if(!(flags & ChunkAwake)) {
+            _statistics.setPending(chunk, _statistics.tile(chunk));
+        }
+
+        if(!_sleepingChunks)
+            return;
+        if(chunkHasFuelNextToFire(chunk))
+            _chunkFlags[chunk] |= ChunkAwake;
+        else
+            _chunkFlags[chunk] &= ~ChunkAwake;
+    });
+
+    _awakeChunks.clear();
+    for(int chunk: _classifyChunks) {
+        _statistics.commit(chunk);
+        _chunkFlags[chunk] &= ~(ChunkQueued | ChunkChanged | ChunkRecount);
+        if(_chunkFlags[chunk] & ChunkAwake)
+            _awakeChunks.push_back(chunk);
+    }
+}
+
+void FireSimulation::stepChunk(const FireStepContext &stepCtx, int chunk) {
+    // The one-cell halo around the chunk is read straight from the front grid,
+    // which stays immutable until every chunk has been written to the back grid
+    FireStepContext ctx = stepCtx;
+    ctx.thresholds = _thresholds.data() + _wind.regionBucket(chunk) * 4;
+    const int chunkX = chunk % _chunksX;
+    const int yBegin = (chunk / _chunksX) * TileSize;
+    const int yEnd = std::min(yBegin + TileSize, _front.height());
+
+    // Rows without fire in or next to them stay empty and skip the kernel
+    const uint64_t live = chunkRowsNearFire(chunk);
+    uint64_t occupied = 0;
+    // The step only ever adds fire
+    uint32_t ignited = 0;
+    uint32_t newlyBurned = 0;
+    for(int y = yBegin; y < yEnd; ++y) {
+        const uint64_t bit = uint64_t(1) << (y - yBegin);
+        uint64_t &out = ctx.dst->row(y)[chunkX];
+        if(!(live & bit)) {
+            out = 0;
+            continue;
+        }
+        _rowKernel(ctx, y, chunkX, chunkX + 1);
+        if(!out)
+            continue;
+        occupied |= bit;
+        ignited += std::popcount(out ^ ctx.src->row(y)[chunkX]);
+        uint64_t &burned = _burned.row(y)[chunkX];
+        newlyBurned += std::popcount(out & ~burned);
+        burned |= out;
+    }
+    _backOccupancy.setRows(chunk, occupied);
+
+    FireTileStats stats = _statistics.tile(chunk);
+    stats.burning += ignited;
+    stats.burned += newlyBurned;
+    _statistics.setPending(chunk, stats);
+    if(ignited)
+        _chunkFlags[chunk] |= ChunkChanged;
+}
+
+uint64_t FireSimulation::chunkRowsNearFire(int chunk) const {
+    const int chunkX = chunk % _chunksX;
+    const int chunkY = chunk / _chunksX;
+    const uint64_t rows = _occupancy.rows(chunk);
+    uint64_t live = rows | (rows << 1) | (rows >> 1);
+    if(chunkX > 0)
+        live |= _occupancy.rows(chunk - 1);
+    if(chunkX + 1 < _chunksX)
+        live |= _occupancy.rows(chunk + 1);
+    // Only chunks above the bottom one are full height and have a row 63
+    if(chunkY > 0)
+        live |= _occupancy.rows(chunk - _chunksX) >> 63;
+    if(chunkY + 1 < _chunksY)
+        live |= _occupancy.rows(chunk + _chunksX) << 63;
+    return live;
+}
+
+uint64_t FireSimulation::chunkRowsOwningEdges(int chunk) const {
+    // Row r owns the edges to its right and to row r + 1
+    const int chunkX = chunk % _chunksX;
+    const int chunkY = chunk / _chunksX;
+    const uint64_t rows = _occupancy.rows(chunk);
+    uint64_t owning = rows | (rows >> 1);
+    if(chunkX + 1 < _chunksX)
+        owning |= _occupancy.rows(chunk + 1);
+    if(chunkY + 1 < _chunksY)
+        owning |= _occupancy.rows(chunk + _chunksX) << 63;
+    return owning;
+}
+
+bool FireSimulation::chunkHasFuelNextToFire(int chunk) const {
+    const int w = chunk % _chunksX;
+    const int yBegin = (chunk / _chunksX) * TileSize;
+    const int wordsPerRow = _front.wordsPerRow();
+    const uint64_t valid = w == wordsPerRow - 1 ? _front.lastWordMask() : ~uint64_t(0);
+
+    for(uint64_t live = chunkRowsNearFire(chunk); live; live &= live - 1) {
+        const int y = yBegin + std::countr_zero(live);
+        if(y >= _front.height())
+            break;
+        const uint64_t *row = _front.row(y);
+        const uint64_t current = row[w];
+        uint64_t sources = (current << 1) | (current >> 1);
+        if(w > 0)
+            sources |= row[w - 1] >> 63;
+        if(w + 1 < wordsPerRow)
+            sources |= row[w + 1] << 63;
+        if(y > 0)
+            sources |= _front.row(y - 1)[w];
+        if(y + 1 < _front.height())
+            sources |= _front.row(y + 1)[w];
+        if(sources & ~current & valid)
+            return true;
+    }
+    return false;
+}
+
+void FireSimulation::setChunkFlag(int chunk, ChunkFlag flag, std::vector<int> &list) {
+    if(!(_chunkFlags[chunk] & flag)) {
+        _chunkFlags[chunk] |= flag;
+        list.push_back(chunk);
+    }
+}
+
+void FireSimulation::wakeAll() {
+    _awakeChunks.clear();
+    _staleChunks.clear();
+    _occupancy.rebuild(_front);
+    _backOccupancy.resize(_front.width(), _front.height());
+    for(int chunk = 0; chunk < static_cast<int>(_chunkFlags.size()); ++chunk) {
+        _chunkFlags[chunk] = (_chunkFlags[chunk] & ChunkDirty) | ChunkAwake | ChunkStale;
+        _awakeChunks.push_back(chunk);
+        _staleChunks.push_back(chunk);
+    }
+}
+
+void FireSimulation::touchCell(int x, int y) {
+    const int chunkX = x / TileSize;
+    const int chunkY = y / TileSize;
+    const int chunk = chunkY * _chunksX + chunkX;
+    _occupancy.updateRow(chunk, y % TileSize, _front.row(y)[x >> 6]);
+    setChunkFlag(chunk, ChunkStale, _staleChunks);
+    setChunkFlag(chunk, ChunkAwake, _awakeChunks);
+
+    // A cell on the chunk border also feeds the neighbouring chunk
+    if(x % TileSize == 0 && chunkX > 0)
+        setChunkFlag(chunk - 1, ChunkAwake, _awakeChunks);
+    if(x % TileSize == TileSize - 1 && chunkX + 1 < _chunksX)
+        setChunkFlag(chunk + 1, ChunkAwake, _awakeChunks);
+    if(y % TileSize == 0 && chunkY > 0)
+        setChunkFlag(chunk - _chunksX, ChunkAwake, _awakeChunks);
+    if(y % TileSize == TileSize - 1 && chunkY + 1 < _chunksY)
+        setChunkFlag(chunk + _chunksX, ChunkAwake, _awakeChunks);
+}
+
+void FireSimulation::setSleepingChunks(bool enabled) {
+    if(_stepInProgress)
+        continueStep(1.0f);
+    _sleepingChunks = enabled;
+    if(!enabled && (_mode == FireStepMode::Dense || _mode == FireStepMode::Tiled))
+        wakeAll();
+}
+
+void FireSimulation::pushFrontier(int x, int y) {
+    if(_inFrontier.ignite(x, y))
+        _frontier.push_back(static_cast<uint32_t>(y) * _front.width() + x);
+}
+
+void FireSimulation::pushBurningNeighbours(int x, int y) {
+    const int neighbours[4][2] = {{x + 1, y}, {x - 1, y}, {x, y + 1}, {x, y - 1}};
+    for(auto [nx, ny]: neighbours) {
+        if(nx >= 0 && nx < _front.width() && ny >= 0 && ny < _front.height() && _front.isBurning(nx, ny))
+            pushFrontier(nx, ny);
+    }
+}
+
+void FireSimulation::rebuildFrontier() {
+    _frontier.clear();
+    _inFrontier.resize(_front.width(), _front.height());
+    for(int y = 0; y < _front.height(); ++y) {
+        for(int x = 0; x < _front.width(); ++x) {
+            if(_front.isBurning(x, y))
+                pushFrontier(x, y);
+        }
+    }
+}
+
+void FireSimulation::setMode(FireStepMode mode) {
+    if(mode == _mode)
+        return;
+    if(_stepInProgress)
+        continueStep(1.0f);
+    _mode = mode;
+
+    _frontier.clear();
+    _nextFrontier.clear();
+    _inFrontier.resize(0, 0);
+    _events = {};
+    // Chunk flags are only maintained by the dense and tiled steps
+    if(_mode == FireStepMode::Frontier)
+        rebuildFrontier();
+    else if(_mode == FireStepMode::Event)
+        rebuildEvents();
+    else
+        wakeAll();
+}
+
+bool FireSimulation::igniteCell(int x, int y) {
+    if(!_front.ignite(x, y))
+        return false;
+    _statistics.cellChanged(_front, x, y, _burned.ignite(x, y));
+    setChunkFlag((y / TileSize) * _chunksX + x / TileSize, ChunkDirty, _dirtyChunks);
+    return true;
+}
+
+bool FireSimulation::extinguishCell(int x, int y) {
+    if(!_front.extinguish(x, y))
+        return false;
+    _statistics.cellChanged(_front, x, y, false);
+    setChunkFlag((y / TileSize) * _chunksX + x / TileSize, ChunkDirty, _dirtyChunks);
+    return true;
+}
+
+void FireSimulation::takeChangedChunks(std::vector<int> &chunks) {
+    for(int chunk: _dirtyChunks) {
+        _chunkFlags[chunk] &= ~ChunkDirty;
+        chunks.push_back(chunk);
+    }
+    _dirtyChunks.clear();
+}
+
+bool FireSimulation::ignite(int x, int y) {
+    if(_stepInProgress) {
+        _deferredEdits.push_back(FireEdit{x, y, 1, 1, true});
+        return false;
+    }
+    bool changed = igniteCell(x, y);
+    if(!changed)
+        return false;
+    if(_mode == FireStepMode::Frontier) {
+        pushFrontier(x, y);
+    } else if(_mode == FireStepMode::Event) {
+        scheduleNeighbours(x, y, _time);
+    } else {
+        touchCell(x, y);
+    }
+    return true;
+}
+
+bool FireSimulation::extinguish(int x, int y) {
+    if(_stepInProgress) {
+        _deferredEdits.push_back(FireEdit{x, y, 1, 1, false});
+        return false;
+    }
+    bool changed = extinguishCell(x, y);
+    if(!changed)
+        return false;
+    if(_mode == FireStepMode::Frontier || _mode == FireStepMode::Event)
+        cellExtinguished(x, y);
+    else
+        touchCell(x, y);
+    return true;
+}
+
+bool FireSimulation::extinguishWord(int w, int y, uint64_t mask) {
+    uint64_t cleared = _front.row(y)[w] & mask;
+    if(!cleared)
+        return false;
+
+    // One cell at a time, the statistics look at the neighbours
+    const bool perCell = _mode == FireStepMode::Frontier || _mode == FireStepMode::Event;
+    for(; cleared; cleared &= cleared - 1) {
+        const int x = w * 64 + std::countr_zero(cleared);
+        extinguishCell(x, y);
+        if(perCell)
+            cellExtinguished(x, y);
+    }
+    if(!perCell) {
+        // Extinguishing only ever creates fuel inside the chunk itself
+        const int chunk = (y / TileSize) * _chunksX + w;
+        _occupancy.updateRow(chunk, y % TileSize, _front.row(y)[w]);
+        setChunkFlag(chunk, ChunkStale, _staleChunks);
+        setChunkFlag(chunk, ChunkAwake, _awakeChunks);
+    }
+    return true;
+}
+
+bool FireSimulation::extinguishInChunk(int w, int chunkY, int x0, int x1, int y0, int y1) {
+    const int chunk = chunkY * _chunksX + w;
+    const int rowBegin = std::max(y0 - chunkY * TileSize, 0);
+    const int rowEnd = std::min(y1 - chunkY * TileSize, TileSize);
+    uint64_t rows = (rowEnd - rowBegin == 64 ? ~uint64_t(0) : ((uint64_t(1) << (rowEnd - rowBegin)) - 1)) << rowBegin;
+    // Only the dense and tiled steps keep the occupancy up to date
+    if(_mode == FireStepMode::Dense || _mode == FireStepMode::Tiled)
+        rows &= _occupancy.rows(chunk);
+    if(!rows)
+        return false;
+
+    const int first = std::max(x0 - w * 64, 0);
+    const int last = std::min(x1 - w * 64, 64);
+    const uint64_t mask = (last - first == 64 ? ~uint64_t(0) : ((uint64_t(1) << (last - first)) - 1)) << first;
+    bool changed = false;
+    for(; rows; rows &= rows - 1)
+        changed |= extinguishWord(w, chunkY * TileSize + std::countr_zero(rows), mask);
+    return changed;
+}
+
+bool FireSimulation::extinguishSpan(int y, int x0, int x1) {
+    if(_stepInProgress) {
+        _deferredEdits.push_back(FireEdit{x0, y, x1 - x0, 1, false});
+        return false;
+    }
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, _front.width());
+    if(y < 0 || y >= _front.height() || x0 >= x1)
+        return false;
+
+    bool changed = false;
+    for(int w = x0 / 64; w <= (x1 - 1) / 64; ++w)
+        changed |= extinguishInChunk(w, y / TileSize, x0, x1, y, y + 1);
+    return changed;
+}
+
+bool FireSimulation::extinguishRect(int x, int y, int width, int height) {
+    if(_stepInProgress) {
+        _deferredEdits.push_back(FireEdit{x, y, width, height, false});
+        return false;
+    }
+    const int xBegin = std::max(x, 0);
+    const int yBegin = std::max(y, 0);
+    const int xEnd = std::min(x + width, _front.width());
+    const int yEnd = std::min(y + height, _front.height());
+    if(xBegin >= xEnd || yBegin >= yEnd)
+        return false;
+
+    bool changed = false;
+    for(int chunkY = yBegin / TileSize; chunkY <= (yEnd - 1) / TileSize; ++chunkY) {
+        for(int w = xBegin / 64; w <= (xEnd - 1) / 64; ++w)
+            changed |= extinguishInChunk(w, chunkY, xBegin, xEnd, yBegin, yEnd);
+    }
+    return changed;
+}
+
+bool FireSimulation::extinguishStamps(FireStampBatch &stamps) {
+    bool changed = false;
+    for(const FireStampBatch::Span &span: stamps.spans())
+        changed |= extinguishSpan(span.y, span.x0, span.x1);
+    return changed;
+}
+
+void FireSimulation::reset() {
+    if(_stepInProgress)
+        continueStep(1.0f);
+    _front.clear();
+    _back.clear();
+    _burned.clear();
+    _statistics.resize(_front.width(), _front.height());
+
+    _frontier.clear();
+    _nextFrontier.clear();
+    _ignitions.clear();
+    _inFrontier.clear();
+    _events = {};
+    wakeAll();
+    for(int chunk = 0; chunk < static_cast<int>(_chunkFlags.size()); ++chunk)
+        setChunkFlag(chunk, ChunkDirty, _dirtyChunks);
+
+    _generation = 0;
+    _time = 0.0;
+    updateStreamKeys();
+}
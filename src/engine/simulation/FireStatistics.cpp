@@ -0,0 +1,87 @@
+#include "engine/simulation/FireStatistics.hpp"
+
+#include <algorithm>
+#include <bit>
+
+FireStatistics::FireStatistics() : _tilesX(0), _tilesY(0), _burning(0), _burned(0), _perimeter(0) {
+}
+
+void FireStatistics::resize(int width, int height) {
+    _tilesX = (width + 63) / 64;
+    _tilesY = (height + TileSize - 1) / TileSize;
+    _tiles.assign(static_cast<size_t>(_tilesX) * _tilesY, FireTileStats{});
+    _pending.assign(_tiles.size(), FireTileStats{});
+    _burning = 0;
+    _burned = 0;
+    _perimeter = 0;
+}
+
+uint32_t FireStatistics::countPerimeter(const FireGrid &grid, int tile, uint64_t rows) {
+    const int tilesX = grid.wordsPerRow();
+    const int w = tile % tilesX;
+    const int yBegin = (tile / tilesX) * TileSize;
+    // Pairs (x, x + 1) inside the word whose right cell exists
+    const uint64_t pairs = (w == tilesX - 1 ? grid.lastWordMask() : ~uint64_t(0)) >> 1;
+
+    uint32_t perimeter = 0;
+    for(; rows; rows &= rows - 1) {
+        const int y = yBegin + std::countr_zero(rows);
+        if(y >= grid.height())
+            break;
+        const uint64_t *row = grid.row(y);
+        const uint64_t current = row[w];
+        perimeter += std::popcount((current ^ (current >> 1)) & pairs);
+        if(w + 1 < tilesX)
+            perimeter += static_cast<uint32_t>((current >> 63) ^ (row[w + 1] & 1));
+        // Padding bits are clear in both rows, so they never count
+        if(y + 1 < grid.height())
+            perimeter += std::popcount(current ^ grid.row(y + 1)[w]);
+    }
+    return perimeter;
+}
+
+void FireStatistics::commit(int tile) {
+    const FireTileStats &next = _pending[tile];
+    FireTileStats &current = _tiles[tile];
+    _burning += static_cast<int64_t>(next.burning) - current.burning;
+    _burned += static_cast<int64_t>(next.burned) - current.burned;
+    _perimeter += static_cast<int64_t>(next.perimeter) - current.perimeter;
+    current = next;
+}
+
+void FireStatistics::addPerimeter(int x, int y, int delta) {
+    _tiles[(y / TileSize) * _tilesX + x / 64].perimeter += delta;
+    _perimeter += delta;
+}
+
+void FireStatistics::cellChanged(const FireGrid &grid, int x, int y, bool newlyBurned) {
+    const bool burning = grid.isBurning(x, y);
+    const int delta = burning ? 1 : -1;
+    FireTileStats &stats = _tiles[(y / TileSize) * _tilesX + x / 64];
+    stats.burning += delta;
+    _burning += delta;
+    if(newlyBurned) {
+        ++stats.burned;
+        ++_burned;
+    }
+
+    // Every edge of the cell flips between perimeter and interior. Each one
+    // is owned by the tile of its left or upper cell.
+    auto edge = [&](int nx, int ny, int ownerX, int ownerY) {
+        if(nx >= 0 && nx < grid.width() && ny >= 0 && ny < grid.height())
+            addPerimeter(ownerX, ownerY, grid.isBurning(nx, ny) != burning ? 1 : -1);
+    };
+    edge(x - 1, y, x - 1, y);
+    edge(x + 1, y, x, y);
+    edge(x, y - 1, x, y - 1);
+    edge(x, y + 1, x, y);
+}
+
+uint64_t FireStatistics::regionDamage(int tileX0, int tileY0, int tileX1, int tileY1) const {
+    uint64_t damage = 0;
+    for(int ty = std::max(tileY0, 0); ty < std::min(tileY1, _tilesY); ++ty) {
+        for(int tx = std::max(tileX0, 0); tx < std::min(tileX1, _tilesX); ++tx)
+            damage += _tiles[static_cast<size_t>(ty) * _tilesX + tx].burned;
+    }
+    return damage;
+}
@@ -0,0 +1,195 @@
+#include "engine/simulation/FireThread.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "engine/simulation/FireLod.hpp"
+#include "engine/simulation/FireSimulation.hpp"
+
+// How often the thread looks for commands while waiting for the next generation
+static const std::chrono::milliseconds PollInterval(2);
+// Shortest time between two snapshots that are not from a step, about a frame
+static const std::chrono::milliseconds PublishInterval(8);
+
+FireThread::FireThread(FireSimulation &fire, double generationSeconds, size_t commandCapacity)
+    : _fire(fire), _lod(nullptr), _generationSeconds(generationSeconds), _stopping(false), _commands(commandCapacity), _droppedCommands(0),
+      _chunkVersions(static_cast<size_t>(fire.chunksX()) * fire.chunksY(), 1), _publishCount(1), _allChanged(false) {}
+
+FireThread::~FireThread() {
+    stop();
+}
+
+void FireThread::start() {
+    if(running())
+        return;
+    // The initial state is published before the thread exists, so the first
+    // acquire already has a grid to show
+    publish(0.0);
+    _stopping.store(false, std::memory_order_relaxed);
+    _thread = std::thread(&FireThread::run, this);
+}
+
+void FireThread::stop() {
+    if(!running())
+        return;
+    _stopping.store(true, std::memory_order_release);
+    _thread.join();
+}
+
+void FireThread::run() {
+    using namespace std::chrono;
+    const auto interval = duration_cast<steady_clock::duration>(duration<double>(_generationSeconds));
+    auto lastTime = steady_clock::now();
+    auto nextStep = lastTime + interval;
+    auto nextPublish = lastTime;
+    bool pending = false;
+
+    while(!_stopping.load(std::memory_order_acquire)) {
+        bool changed = applyCommands();
+        bool stepped = false;
+        double stepMilliseconds = 0.0;
+
+        auto now = steady_clock::now();
+        const bool coarse = _lod && _lod->active();
+        if(!coarse && _fire.mode() == FireStepMode::Event) {
+            changed |= _fire.advance(duration<double>(now - lastTime).count() / _generationSeconds) > 0;
+        } else if(now >= nextStep) {
+            if(coarse)
+                _lod->step();
+            else
+                _fire.step();
+            stepMilliseconds = duration<double, std::milli>(steady_clock::now() - now).count();
+            // Falling behind skips generations instead of bursting to catch up
+            nextStep = std::max(nextStep + interval, now);
+            stepped = true;
+        }
+        lastTime = now;
+        // Edits and event mode change the grid on nearly every poll, nothing
+        // draws them faster than once a frame
+        pending |= changed || stepped;
+        if(pending && (stepped || now >= nextPublish)) {
+            publish(stepMilliseconds);
+            pending = false;
+            nextPublish = now + PublishInterval;
+        }
+
+        std::this_thread::sleep_until(std::min(nextStep, steady_clock::now() + PollInterval));
+    }
+}
+
+bool FireThread::applyCommands() {
+    bool changed = false;
+    FireCommand command;
+    while(_commands.pop(command)) {
+        const bool coarse = _lod && _lod->active();
+        if(command.type == FireCommand::SetDetail) {
+            if(_lod && coarse != (command.x0 != 0)) {
+                if(coarse)
+                    _lod->leave(_fire);
+                else
+                    _lod->enter(_fire);
+                // Expanded coarse and fine grids differ all over
+                _allChanged = true;
+                changed = true;
+            }
+        } else if(command.type == FireCommand::Ignite) {
+            changed |= coarse ? _lod->ignite(command.x0, command.y) : _fire.ignite(command.x0, command.y);
+        } else {
+            changed |= coarse ? _lod->extinguishSpan(command.y, command.x0, command.x1)
+                              : _fire.extinguishSpan(command.y, command.x0, command.x1);
+        }
+    }
+    return changed;
+}
+
+void FireThread::publish(double stepMilliseconds) {
+    FireSnapshot &snapshot = _snapshots.back();
+    const FireGrid &grid = _fire.grid();
+    if(snapshot.grid.width() != grid.width() || snapshot.grid.height() != grid.height()) {
+        snapshot.grid.resize(grid.width(), grid.height());
+        snapshot.burned.resize(grid.width(), grid.height());
+        snapshot.chunkVersions.assign(_chunkVersions.size(), 0);
+    }
+
+    ++_publishCount;
+    _changedChunks.clear();
+    _fire.takeChangedChunks(_changedChunks);
+    if(_lod)
+        _lod->takeChangedChunks(_changedChunks);
+    if(_allChanged) {
+        std::fill(_chunkVersions.begin(), _chunkVersions.end(), _publishCount);
+        _allChanged = false;
+    }
+    for(int chunk: _changedChunks)
+        _chunkVersions[chunk] = _publishCount;
+    // The slot was last written a few publishes ago, whatever changed since
+    // then is copied over
+    for(int chunk = 0; chunk < static_cast<int>(_chunkVersions.size()); ++chunk) {
+        if(snapshot.chunkVersions[chunk] != _chunkVersions[chunk]) {
+            copyChunk(snapshot, chunk);
+            snapshot.chunkVersions[chunk] = _chunkVersions[chunk];
+        }
+    }
+
+    if(_lod && _lod->active()) {
+        // Block counts scaled to cells, exact only where whole blocks burn
+        const size_t factor = static_cast<size_t>(_lod->factor());
+        const FireStatistics &stats = _lod->coarse().statistics();
+        snapshot.generation = _lod->generation();
+        snapshot.burningCount = stats.burningCount() * factor * factor;
+        snapshot.burnedArea = stats.burnedArea() * factor * factor;
+        snapshot.perimeter = stats.perimeter() * factor;
+    } else {
+        const FireStatistics &stats = _fire.statistics();
+        snapshot.generation = _fire.generation();
+        snapshot.burningCount = stats.burningCount();
+        snapshot.burnedArea = stats.burnedArea();
+        snapshot.perimeter = stats.perimeter();
+    }
+    snapshot.stepMilliseconds = stepMilliseconds;
+    _snapshots.publish();
+}
+
+void FireThread::copyChunk(FireSnapshot &snapshot, int chunk) {
+    const int w = chunk % _fire.chunksX();
+    const int yBegin = (chunk / _fire.chunksX()) * FireSimulation::TileSize;
+    const int yEnd = std::min(yBegin + FireSimulation::TileSize, snapshot.grid.height());
+    const bool coarse = _lod && _lod->active();
+    if(coarse)
+        _lod->expandChunk(snapshot.grid, chunk);
+    for(int y = yBegin; y < yEnd; ++y) {
+        if(!coarse)
+            snapshot.grid.row(y)[w] = _fire.grid().row(y)[w];
+        snapshot.burned.row(y)[w] = _fire.burned().row(y)[w];
+    }
+}
+
+bool FireThread::push(const FireCommand &command) {
+    if(_commands.push(command))
+        return true;
+    _droppedCommands.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool FireThread::ignite(int x, int y) {
+    return push(FireCommand{FireCommand::Ignite, y, x, x + 1});
+}
+
+bool FireThread::extinguishSpan(int y, int x0, int x1) {
+    return push(FireCommand{FireCommand::Extinguish, y, x0, x1});
+}
+
+bool FireThread::extinguishStamps(FireStampBatch &stamps) {
+    bool queued = true;
+    for(const FireStampBatch::Span &span: stamps.spans())
+        queued &= extinguishSpan(span.y, span.x0, span.x1);
+    return queued;
+}
+
+bool FireThread::setCoarse(bool coarse) {
+    return push(FireCommand{FireCommand::SetDetail, 0, coarse ? 1 : 0, 0});
+}
+
+const FireSnapshot *FireThread::acquire() {
+    return _snapshots.acquire() ? &_snapshots.front() : nullptr;
+}
@@ -0,0 +1,84 @@
+#include "engine/simulation/ForestCells.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/PerlinNoise.hpp"
+
+// Noise is sampled on a lattice this many cells apart and interpolated in
+// between, Perlin noise is far too slow to evaluate for every cell of a big map
+static const int SampleSpacing = 8;
+
+ForestCells::ForestCells() : _width(0), _height(0), _stride(0) {
+}
+
+ForestCells::ForestCells(int width, int height) : ForestCells() {
+    resize(width, height);
+}
+
+void ForestCells::resize(int width, int height) {
+    _width = width;
+    _height = height;
+    _stride = static_cast<size_t>((width + 63) / 64) * 64;
+    size_t size = _stride * height;
+    _fuel.assign(size, 0);
+    _moisture.assign(size, 0);
+    _heat.assign(size, 0);
+    _flammability.assign(size, 0);
+}
+
+void ForestCells::generate(unsigned int seed, float featureSize) {
+    PerlinNoise noise(seed);
+    const int samplesX = _width / SampleSpacing + 2;
+    const int samplesY = _height / SampleSpacing + 2;
+    const double frequency = SampleSpacing / std::max(1.0, static_cast<double>(featureSize));
+
+    // Each field reads its own slice of the 3D noise, with a second octave for detail
+    std::vector<float> lattice[3];
+    uint8_t *fields[3] = {_fuel.data(), _moisture.data(), _heat.data()};
+    for(int field = 0; field < 3; ++field) {
+        lattice[field].resize(static_cast<size_t>(samplesX) * samplesY);
+        const double z = field * 17.5 + 0.5;
+        for(int sy = 0; sy < samplesY; ++sy) {
+            for(int sx = 0; sx < samplesX; ++sx) {
+                double n = noise.noise(sx * frequency, sy * frequency, z) +
+                           0.5 * noise.noise(sx * frequency * 2.0, sy * frequency * 2.0, z + 8.25);
+                lattice[field][static_cast<size_t>(sy) * samplesX + sx] =
+                    static_cast<float>(std::clamp((n / 1.5 * 0.5 + 0.5) * 255.0, 0.0, 255.0));
+            }
+        }
+    }
+
+    for(int y = 0; y < _height; ++y) {
+        const int sy = y / SampleSpacing;
+        const float ty = static_cast<float>(y % SampleSpacing) / SampleSpacing;
+        for(int field = 0; field < 3; ++field) {
+            const float *top = lattice[field].data() + static_cast<size_t>(sy) * samplesX;
+            const float *bottom = top + samplesX;
+            uint8_t *out = fields[field] + static_cast<size_t>(y) * _stride;
+            for(int x = 0; x < _width; ++x) {
+                const int sx = x / SampleSpacing;
+                const float tx = static_cast<float>(x % SampleSpacing) / SampleSpacing;
+                float upper = top[sx] + (top[sx + 1] - top[sx]) * tx;
+                float lower = bottom[sx] + (bottom[sx + 1] - bottom[sx]) * tx;
+                out[x] = static_cast<uint8_t>(upper + (lower - upper) * ty + 0.5f);
+            }
+        }
+    }
+
+    updateFlammability();
+}
+
+void ForestCells::updateFlammability() {
+    // Every term is scaled by 128, so neutral conditions land on 128:
+    // fuel 0.25 to 1.75, moisture 1.5 down to 0.5 and heat 0.75 to 1.25
+    for(int y = 0; y < _height; ++y) {
+        const size_t begin = static_cast<size_t>(y) * _stride;
+        for(int x = 0; x < _width; ++x) {
+            uint32_t fuelTerm = 32 + ((3u * _fuel[begin + x]) >> 2);
+            uint32_t moistureTerm = 192 - (_moisture[begin + x] >> 1);
+            uint32_t heatTerm = 96 + (_heat[begin + x] >> 2);
+            _flammability[begin + x] = static_cast<uint8_t>(std::min<uint32_t>((fuelTerm * moistureTerm * heatTerm) >> 14, 255));
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#include "engine/simulation/WindField.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+// Spread factor downwind at full strength is e^WindGain, upwind its inverse
+static const float WindGain = 1.5f;
+
+WindField::WindField() : _regionsX(0), _regionsY(0) {
+}
+
+WindField::WindField(int width, int height) : WindField() {
+    resize(width, height);
+}
+
+void WindField::resize(int width, int height) {
+    _regionsX = (width + RegionSize - 1) / RegionSize;
+    _regionsY = (height + RegionSize - 1) / RegionSize;
+    _buckets.assign(static_cast<size_t>(_regionsX) * _regionsY, 0);
+}
+
+uint8_t WindField::bucket(float angle, float strength) {
+    const float turn = 2.0f * std::numbers::pi_v<float>;
+    int angleStep = static_cast<int>(std::lround(angle / turn * AngleSteps)) % AngleSteps;
+    if(angleStep < 0)
+        angleStep += AngleSteps;
+    int strengthStep = static_cast<int>(std::lround(std::clamp(strength, 0.0f, 1.0f) * (StrengthSteps - 1)));
+    return static_cast<uint8_t>(strengthStep * AngleSteps + angleStep);
+}
+
+float WindField::spreadFactor(uint8_t bucket, int dx, int dy) {
+    const float angle = (bucket % AngleSteps) * 2.0f * std::numbers::pi_v<float> / AngleSteps;
+    const float strength = static_cast<float>(bucket / AngleSteps) / (StrengthSteps - 1);
+    const float along = std::cos(angle) * dx + std::sin(angle) * dy;
+    return std::exp(WindGain * strength * along);
+}
+
+void WindField::setUniform(float angle, float strength) {
+    std::fill(_buckets.begin(), _buckets.end(), bucket(angle, strength));
+}
+
+void WindField::setRegion(int regionX, int regionY, float angle, float strength) {
+    if(regionX < 0 || regionX >= _regionsX || regionY < 0 || regionY >= _regionsY)
+        return;
+    _buckets[static_cast<size_t>(regionY) * _regionsX + regionX] = bucket(angle, strength);
+}
@@ -20,6 +20,11 @@ int Game::init() {
     GLuint fragmentShader = createShaderFromFile(PathUtils::absolutePath("/assets/shaders/main.frag"), GL_FRAGMENT_SHADER);
 
     _window.setShaderProgram(vertexShader, fragmentShader);
+    GLuint paletteShader = createShaderFromFile(PathUtils::absolutePath("/assets/shaders/palette.frag"), GL_FRAGMENT_SHADER);
+    _window.setPaletteShaderProgram(vertexShader, paletteShader);
+    GLuint spriteVertexShader = createShaderFromFile(PathUtils::absolutePath("/assets/shaders/sprite.vert"), GL_VERTEX_SHADER);
+    GLuint spriteFragmentShader = createShaderFromFile(PathUtils::absolutePath("/assets/shaders/sprite.frag"), GL_FRAGMENT_SHADER);
+    _window.setSpriteShaderProgram(spriteVertexShader, spriteFragmentShader);
 
     run();
 
@@ -33,7 +38,7 @@ void Game::run() {
 
     _running = true;
 
-    _currentScene = new GameScene(&_window);
+    _currentScene = new GameScene(&_window, conf::worldDimensions());
     _currentScene->init();
 
     const int FPS = 120;
@@ -1,16 +1,38 @@
 #include "game/GameScene.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ctime>
+#include <iterator>
+#include <numbers>
 #include <spdlog/spdlog.h>
 
 #include "engine/rendering/RenderWindow.hpp"
 #include "engine/rendering/Texture.hpp"
+#include "engine/simulation/FireGrid.hpp"
 #include "game/EntityComponents.hpp"
+#include "game/GameConfig.hpp"
 #include "utils/PathUtils.hpp"
 
 const int gridMultiplier = 100;
 
+// RGBA colours of the FireCellState palette indices
+static const float firePalette[] = {
+    90 / 255.0f,  255 / 255.0f, 90 / 255.0f, 1.0f, // Forest
+    255 / 255.0f, 0 / 255.0f,   0 / 255.0f,  1.0f, // Burning
+    70 / 255.0f,  60 / 255.0f,  50 / 255.0f, 1.0f  // Extinguished
+};
+
+// Independent random streams derived from the scene seed
+enum RandomStream : uint64_t {
+    EnemySpawnStream = 1,
+    EnemyWanderStream,
+    FireIgnitionStream,
+    FireSpreadStream,
+    ForestStream
+};
+
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
     if(key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
@@ -27,61 +49,130 @@ void createPlayer(entt::registry &registry) {
     registry.emplace<PlayerControlled>(player, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D);
 }
 
-void createEnemies(entt::registry &registry) {
+void createEnemies(entt::registry &registry, const CounterRng &rng) {
     using namespace ecs::comp;
     Texture texture = createTextureFromFile(PathUtils::absolutePath("/assets/textures/zombie.jpg"));
-    srand(time(nullptr));
     for(int i = 0; i < 10; i++) {
+        CounterRng enemyRng = rng.derive(i);
         auto enemy = registry.create();
-        float x = (rand() % 20) * 10.0f - 95.0f;
-        float y = (rand() % 20) * 10.0f - 95.0f;
+        float x = enemyRng.range(0, 0, 20) * 10.0f - 95.0f;
+        float y = enemyRng.range(1, 0, 20) * 10.0f - 95.0f;
         registry.emplace<Position>(enemy, x, y);
         registry.emplace<Velocity>(enemy, 0.0f, 0.0f);
         registry.emplace<Renderable>(enemy, texture, 10.0f);
-        registry.emplace<AiWanderingControlled>(enemy, rand() % 200 - 100.0f, rand() % 200 - 100.0f);
+        registry.emplace<AiWanderingControlled>(enemy, enemyRng.range(2, -100, 100) * 1.0f, enemyRng.range(3, -100, 100) * 1.0f);
     }
 }
 
 void GameScene::init() {
     using namespace ecs::comp;
-    _window->createBackgroundTextureBuffer(200, 200);
-
-    // Map PBO to CPU, update data, unmap PBO
-    GLubyte *ptr = _window->mapPBO();
-    if(ptr) {
-        // Update ptr with your data, e.g., fire effect
-        // Example: set all pixels to red
-        srand(time(nullptr));
-        for(int i = 0; i < 200 * 200 * 4; i += 4) {
-            if(rand() % 1000 == 0) {
-                ptr[i] = 255;     // R
-                ptr[i + 1] = 0;   // G
-                ptr[i + 2] = 0;   // B
-                ptr[i + 3] = 255; // A
-            } else {
-                ptr[i] = 90;      // R
-                ptr[i + 1] = 255; // G
-                ptr[i + 2] = 90;  // B
-                ptr[i + 3] = 255; // A
-            }
-        }
-        _window->unmapPBO();
+    _window->createBackgroundTextureBuffer(_world.gridWidth, _world.gridHeight, conf::paletteBackground.getValue());
+    _window->setPalette(firePalette, static_cast<int>(std::size(firePalette) / 4));
+    _instancedSprites = conf::instancedSprites.getValue() && _window->hasInstancedSprites();
+    // The new texture and every PBO slice hold nothing yet, the first upload
+    // from each slice covers all of it
+    _backgroundRects.setTargets(_window->pboSlices());
+    spdlog::info("Fire grid {}x{}", _world.gridWidth, _world.gridHeight);
+
+    // Frontier mode only visits burning cells next to unburnt forest, tiled mode
+    // spreads whole-grid steps over worker threads for very large maps and event
+    // mode only pays for cells that actually ignite
+    int mode = conf::fireStepMode.getValue();
+    if(mode == static_cast<int>(FireStepMode::Tiled)) {
+        _fireWorkers = std::make_unique<WorkerPool>(conf::fireThreads.getValue());
+        _fire.setWorkerPool(_fireWorkers.get());
+        _fire.setMode(FireStepMode::Tiled);
+        spdlog::info("Tiled fire step on {} threads, {} kernel", _fireWorkers->threadCount(), fireKernelName(_fire.kernel()));
+    } else if(mode == static_cast<int>(FireStepMode::Dense)) {
+        _fire.setMode(FireStepMode::Dense);
+    } else if(mode == static_cast<int>(FireStepMode::Event)) {
+        _fire.setMode(FireStepMode::Event);
+    } else {
+        _fire.setMode(FireStepMode::Frontier);
+    }
+    uint64_t seed = conf::seed.getValue();
+    if(seed == 0)
+        seed = static_cast<uint64_t>(time(nullptr));
+    spdlog::info("Game seed: {}", seed);
+    _rng = CounterRng(seed);
+    _tick = 0;
+
+    _fire.setSeed(_rng.derive(FireSpreadStream).key());
+    // Grid rows grow with world y, so degrees counter-clockwise from east map
+    // straight onto the wind angle
+    float windAngle = conf::windDirection.getValue() * std::numbers::pi_v<float> / 180.0f;
+    _fire.wind().setUniform(windAngle, conf::windStrength.getValue() / 100.0f);
+    if(conf::forestModel.getValue()) {
+        _forest.generate(static_cast<unsigned int>(_rng.derive(ForestStream).key()));
+        _fire.setForest(&_forest);
+    }
+    // One cell in ignitionOdds starts burning. Jumping over geometrically
+    // distributed gaps keeps seeding proportional to the number of fires rather
+    // than to the area of the map.
+    static const double ignitionOdds = 1000.0;
+    const double logSkip = std::log1p(-1.0 / ignitionOdds);
+    CounterRng ignitionRng = _rng.derive(FireIgnitionStream);
+    const uint64_t cellCount = _world.cellCount();
+    uint64_t cell = 0;
+    for(uint64_t draw = 0;; ++draw) {
+        cell += static_cast<uint64_t>(std::log1p(-ignitionRng.uniform(draw)) / logSkip);
+        if(cell >= cellCount)
+            break;
+        _fire.ignite(static_cast<int>(cell % _world.gridWidth), static_cast<int>(cell / _world.gridWidth));
+        ++cell;
+    }
+    _backgroundDirty = true;
+    _backgroundLive = false;
+
+    _fireStepSlices = std::max(1, static_cast<int>(conf::fireStepSlices.getValue()));
+    if(conf::fireHistoryLength.getValue() > 0)
+        _fireHistory = std::make_unique<FireHistory>(conf::fireHistoryLength.getValue(), conf::fireKeyframeInterval.getValue());
+    _replaying = false;
+    _fireCoarse = false;
+    _detailKeyDown = false;
+    const int lodFactor = conf::fireLodFactor.getValue();
+    if(lodFactor == 2 || lodFactor == 4) {
+        _fireLod = std::make_unique<FireLod>(_world.gridWidth, _world.gridHeight, lodFactor);
+        // Calibrated in the background so the first switch to coarse does not stall
+        _fireLod->prepare(_fire.spreadChance());
+        _lodGrid.resize(_world.gridWidth, _world.gridHeight);
+    } else if(lodFactor != 0) {
+        spdlog::error("FireLodFactor must be 0, 2 or 4, not {}; coarse fire detail disabled", lodFactor);
     }
 
+    // Entities clear extinguishRadius world units around them
+    static const float extinguishRadius = 5.0f;
+    const int radiusX = std::max(1, static_cast<int>(std::lround(extinguishRadius * _world.cellsPerUnitX())));
+    const int radiusY = std::max(1, static_cast<int>(std::lround(extinguishRadius * _world.cellsPerUnitY())));
+    BrushShape shape = conf::extinguishShape.getValue() == 1 ? BrushShape::Circle : BrushShape::Square;
+    _extinguishBrush = FireBrush(shape, radiusX, radiusY);
+
     _window->setKeyCallback(keyCallback);
     createPlayer(_registry);
-    createEnemies(_registry);
+    createEnemies(_registry, _rng.derive(EnemySpawnStream));
 
     auto view = _registry.view<Renderable>();
     for(auto entity: view) {
         auto &renderable = view.get<Renderable>(entity);
         _window->loadTexture(renderable.texture);
     }
+
+    // Started last, from here on _fire belongs to the fire thread
+    if(conf::fireThread.getValue()) {
+        _fireThread = std::make_unique<FireThread>(_fire);
+        _fireThread->setLod(_fireLod.get());
+        _fireThread->start();
+    }
 }
 
 void GameScene::discard() {
     _window->setKeyCallback(nullptr);
     _registry.clear();
+    _fireThread.reset();
+    _fireLod.reset();
+    _fireHistory.reset();
+    _fire.setWorkerPool(nullptr);
+    _fireWorkers.reset();
 }
 
 void GameScene::processInput() {
@@ -113,6 +204,49 @@ void GameScene::processInput() {
         x++;
     }
 
+    // Left and right scrub the background through the fire history, one
+    // generation per frame; scrubbing past the newest one returns to live
+    if(_fireHistory && !_fireHistory->empty()) {
+        if(key(GLFW_KEY_LEFT)) {
+            uint64_t shown = _replaying ? _replayGeneration : _fireHistory->newestGeneration();
+            if(shown > _fireHistory->oldestGeneration()) {
+                _replaying = true;
+                _replayGeneration = shown - 1;
+                _backgroundDirty = true;
+            }
+        } else if(key(GLFW_KEY_RIGHT) && _replaying) {
+            if(++_replayGeneration >= _fireHistory->newestGeneration())
+                _replaying = false;
+            _backgroundDirty = true;
+        }
+    }
+
+    // Z switches the fire between full and coarse detail, standing in for
+    // zooming out until the game has a camera
+    bool detailKey = key(GLFW_KEY_Z);
+    if(_fireLod && detailKey && !_detailKeyDown) {
+        const bool coarse = !_fireCoarse;
+        if(_fireThread) {
+            // A full queue drops the switch, the next press tries again
+            if(_fireThread->setCoarse(coarse))
+                _fireCoarse = coarse;
+        } else {
+            if(_fire.stepInProgress())
+                _fire.continueStep(1.0f);
+            if(coarse)
+                _fireLod->enter(_fire);
+            else
+                _fireLod->leave(_fire);
+            _fireCoarse = coarse;
+            _backgroundDirty = true;
+        }
+        if(_fireCoarse == coarse)
+            spdlog::info("Fire detail {}", _fireCoarse ? "coarse" : "full");
+        else
+            spdlog::warn("Fire command queue full, detail switch dropped");
+    }
+    _detailKeyDown = detailKey;
+
     if(x && y) {
         vel.x = x * playerSpeed / 1.41421356f;
         vel.y = y * playerSpeed / 1.41421356f;
@@ -129,14 +263,14 @@ void GameScene::handleMovement(float deltaTime) {
     for(auto entity: view) {
         auto &pos = view.get<Position>(entity);
         auto &vel = view.get<Velocity>(entity);
-        if(pos.x > 100.0f)
-            pos.x = 100.0f;
-        if(pos.x < -100.0f)
-            pos.x = -100.0f;
-        if(pos.y > 100.0f)
-            pos.y = 100.0f;
-        if(pos.y < -100.0f)
-            pos.y = -100.0f;
+        if(pos.x > _world.halfExtent)
+            pos.x = _world.halfExtent;
+        if(pos.x < -_world.halfExtent)
+            pos.x = -_world.halfExtent;
+        if(pos.y > _world.halfExtent)
+            pos.y = _world.halfExtent;
+        if(pos.y < -_world.halfExtent)
+            pos.y = -_world.halfExtent;
         pos.x += vel.x * deltaTime;
         pos.y += vel.y * deltaTime;
     }
@@ -148,17 +282,19 @@ void GameScene::handleEnemies(float deltaTime) {
     static double startTime = std::clock() / (double)CLOCKS_PER_SEC;
 
     auto view = _registry.view<Position, Velocity, AiWanderingControlled>();
+    CounterRng tickRng = _rng.derive(EnemyWanderStream).derive(_tick);
 
     for(auto &entity: view) {
         auto &pos = view.get<Position>(entity);
         auto &vel = view.get<Velocity>(entity);
         auto &ai = view.get<AiWanderingControlled>(entity);
 
-        float incrementX = (rand() % 200 - 100) / 10.0f;
-        if(ai.dx + incrementX > 100.0f || ai.dx + incrementX < -100.0f)
+        uint64_t counter = static_cast<uint64_t>(entt::to_integral(entity)) * 2;
+        float incrementX = tickRng.range(counter, -100, 100) / 10.0f;
+        if(ai.dx + incrementX > _world.halfExtent || ai.dx + incrementX < -_world.halfExtent)
             incrementX = -incrementX;
-        float incrementY = (rand() % 200 - 100) / 10.0f;
-        if(ai.dy + incrementY > 100.0f || ai.dy + incrementY < -100.0f)
+        float incrementY = tickRng.range(counter + 1, -100, 100) / 10.0f;
+        if(ai.dy + incrementY > _world.halfExtent || ai.dy + incrementY < -_world.halfExtent)
             incrementY = -incrementY;
 
         ai.dx += incrementX;
@@ -177,91 +313,83 @@ void GameScene::handleEnemies(float deltaTime) {
     }
 }
 
-void GameScene::update(float deltaTime) {
-    handleEnemies(deltaTime);
-    handleMovement(deltaTime);
-
+void GameScene::stepFire(float deltaTime) {
     using namespace std::chrono;
     static auto lastFireTick = high_resolution_clock::now();
     auto currentFireTick = high_resolution_clock::now();
-    static const float fireSpreadChance = 0.3f; // Configurable chance for fire to spread
 
-    GLubyte *ptr = _window->mapPBO();
-    if(duration_cast<milliseconds>(currentFireTick - lastFireTick) > milliseconds(1000)) {
-        lastFireTick = currentFireTick;
-        if(ptr) {
-            std::vector<GLubyte> newBuffer(200 * 200 * 4);
-            std::copy(ptr, ptr + 200 * 200 * 4, newBuffer.begin());
-
-            for(int y = 0; y < 200; ++y) {
-                for(int x = 0; x < 200; ++x) {
-                    int i = (y * 200 + x) * 4; // Calculate the index for pixel (x, y)
-                    if(ptr[i] == 255 && ptr[i + 1] == 0 && ptr[i + 2] == 0) { // Check if the current pixel is on fire (red)
-                        // Spread the fire to adjacent pixels if they are not already red and pass the spread chance check
-                        if(x < 199 && static_cast<float>(rand()) / RAND_MAX < fireSpreadChance) { // Right
-                            newBuffer[i + 4] = 255;     // R
-                            newBuffer[i + 4 + 1] = 0;   // G
-                            newBuffer[i + 4 + 2] = 0;   // B
-                        }
-                        if(x > 0 && static_cast<float>(rand()) / RAND_MAX < fireSpreadChance) { // Left
-                            newBuffer[i - 4] = 255;     // R
-                            newBuffer[i - 4 + 1] = 0;   // G
-                            newBuffer[i - 4 + 2] = 0;   // B
-                        }
-                        if(y < 199 && static_cast<float>(rand()) / RAND_MAX < fireSpreadChance) { // Down
-                            int indexDown = ((y + 1) * 200 + x) * 4;
-                            newBuffer[indexDown] = 255;   // R
-                            newBuffer[indexDown + 1] = 0; // G
-                            newBuffer[indexDown + 2] = 0; // B
-                        }
-                        if(y > 0 && static_cast<float>(rand()) / RAND_MAX < fireSpreadChance) { // Up
-                            int indexUp = ((y - 1) * 200 + x) * 4;
-                            newBuffer[indexUp] = 255;   // R
-                            newBuffer[indexUp + 1] = 0; // G
-                            newBuffer[indexUp + 2] = 0; // B
-                        }
-                    }
-                }
-            }
-            std::copy(newBuffer.begin(), newBuffer.end(), ptr);
+    // Event driven fire ignites cells at their exact times, one generation per second.
+    // Otherwise a generation starts every second and is spread over fireStepSlices
+    // updates, the background keeps showing the previous one until it is published.
+    bool published = false;
+    const bool coarse = _fireLod && _fireLod->active();
+    if(coarse) {
+        if(duration_cast<milliseconds>(currentFireTick - lastFireTick) > milliseconds(1000)) {
+            lastFireTick = currentFireTick;
+            _fireStepTime = 0.0;
+            _fireLod->step();
+            published = true;
         }
+    } else if(_fire.mode() == FireStepMode::Event) {
+        if(_fire.advance(deltaTime))
+            _backgroundDirty = true;
+    } else if(_fire.stepInProgress()) {
+        published = _fire.continueStep(1.0f / _fireStepSlices);
+    } else if(duration_cast<milliseconds>(currentFireTick - lastFireTick) > milliseconds(1000)) {
+        lastFireTick = currentFireTick;
+        _fireStepTime = 0.0;
+        published = _fire.beginStep() || _fire.continueStep(1.0f / _fireStepSlices);
     }
 
+    if(_fire.stepInProgress() || published)
+        _fireStepTime += duration<double, std::milli>(high_resolution_clock::now() - currentFireTick).count();
+    if(published) {
+        _backgroundDirty = true;
+        // Coarse statistics count blocks rather than cells
+        const FireStatistics &stats = coarse ? _fireLod->coarse().statistics() : _fire.statistics();
+        spdlog::debug("Fire generation {} took {:.2f} ms: {} burning, {} burnt, perimeter {}",
+                      coarse ? _fireLod->generation() : _fire.generation(), _fireStepTime, stats.burningCount(),
+                      stats.burnedArea(), stats.perimeter());
+    }
+}
+
+void GameScene::update(float deltaTime) {
+    ++_tick;
+    handleEnemies(deltaTime);
+    handleMovement(deltaTime);
+
+    if(!_fireThread)
+        stepFire(deltaTime);
+
     using namespace ecs::comp;
+    // Overlapping stamps are merged so every cell is cleared once
+    _extinguishStamps.clear();
     auto view = _registry.view<Position, Velocity>();
-    for (auto entity : view) {
+    for(auto entity: view) {
         auto &pos = view.get<Position>(entity);
-        // Convert coordinates from [-100, 100] to [0, 199]
-        int x = static_cast<int>((pos.x + 100.0f) * 0.995f);
-        int y = static_cast<int>((pos.y + 100.0f) * 0.995f);
-        for (int i = x - 5; i <= x + 5; ++i) {
-            for (int j = y - 5; j <= y + 5; ++j) {
-                // Check if (i, j) is within bounds
-                if (i >= 0 && i < 200 && j >= 0 && j < 200) {
-                    int index = (j * 200 + i) * 4;
-                    ptr[index] = 90;
-                    ptr[index + 1] = 255;
-                    ptr[index + 2] = 90;
-                }
-            }
-        }
+        _extinguishStamps.add(_world.worldToCellX(pos.x), _world.worldToCellY(pos.y), _extinguishBrush);
+    }
+    if(_fireThread) {
+        _fireThread->extinguishStamps(_extinguishStamps);
+    } else if(_fireLod && _fireLod->active()) {
+        for(const FireStampBatch::Span &span: _extinguishStamps.spans())
+            _backgroundDirty |= _fireLod->extinguishSpan(span.y, span.x0, span.x1);
+    } else if(_fire.extinguishStamps(_extinguishStamps)) {
+        _backgroundDirty = true;
     }
-    _window->unmapPBO();
 }
 
-void GameScene::draw(float deltaTime) {
+void GameScene::submitEntities(float deltaTime, const EntitySubmit &submit) {
     using namespace ecs::comp;
 
-    _window->updateTextureFromPBO();
-
-    _window->drawBackground();
-
+    const float aspectRatio = _window->aspectRatio();
     auto staticView = _registry.view<Position, Renderable>(entt::exclude<Velocity>);
     for(auto entity: staticView) {
         auto &pos = staticView.get<Position>(entity);
         auto &renderable = staticView.get<Renderable>(entity);
 
-        _window->drawTexture(pos.x / gridMultiplier, pos.y / gridMultiplier, renderable.size / gridMultiplier, renderable.texture);
+        auto [width, height] = RenderWindow::scaledSize(renderable.size / gridMultiplier, renderable.texture, aspectRatio);
+        submit(pos.x / gridMultiplier, pos.y / gridMultiplier, width, height, renderable.texture, 0);
     }
 
     auto view = _registry.view<Position, Velocity, Renderable>();
@@ -273,7 +401,125 @@ void GameScene::draw(float deltaTime) {
         float x = pos.x + (vel.x * deltaTime);
         float y = pos.y + (vel.y * deltaTime);
 
-        _window->drawTexture(x / gridMultiplier, y / gridMultiplier, renderable.size / gridMultiplier, renderable.texture);
+        auto [width, height] = RenderWindow::scaledSize(renderable.size / gridMultiplier, renderable.texture, aspectRatio);
+        submit(x / gridMultiplier, y / gridMultiplier, width, height, renderable.texture, 1);
+    }
+}
+
+void GameScene::draw(float deltaTime) {
+    using namespace ecs::comp;
+
+    // The fire thread publishes a new snapshot whenever its grid changed,
+    // _fire itself belongs to the thread while it runs
+    const FireGrid *fireGrid;
+    const FireGrid *fireBurned;
+    uint64_t fireGeneration;
+    if(_fireThread) {
+        if(const FireSnapshot *snapshot = _fireThread->acquire()) {
+            _backgroundDirty = true;
+            if(snapshot->stepMilliseconds > 0.0)
+                spdlog::debug("Fire generation {} took {:.2f} ms: {} burning, {} burnt, perimeter {}", snapshot->generation,
+                              snapshot->stepMilliseconds, snapshot->burningCount, snapshot->burnedArea, snapshot->perimeter);
+        }
+        fireGrid = &_fireThread->latest().grid;
+        fireBurned = &_fireThread->latest().burned;
+        fireGeneration = _fireThread->latest().generation;
+    } else if(_fireLod && _fireLod->active()) {
+        if(_backgroundDirty)
+            _fireLod->expand(_lodGrid);
+        fireGrid = &_lodGrid;
+        fireBurned = &_fire.burned();
+        fireGeneration = _fireLod->generation();
+    } else {
+        fireGrid = &_fire.grid();
+        fireBurned = &_fire.burned();
+        fireGeneration = _fire.generation();
+    }
+
+    // Every generation is recorded as it is first shown, scrubbing shows a
+    // recorded one instead of the live grid
+    if(_fireHistory && _backgroundDirty) {
+        _fireHistory->record(*fireGrid, fireGeneration);
+        if(_replaying) {
+            // Only burning cells are recorded, the burnt area of the present
+            // would show the future
+            if(_fireHistory->restore(_replayGeneration, _replayGrid)) {
+                fireGrid = &_replayGrid;
+                fireBurned = nullptr;
+            } else
+                _replaying = false;
+        }
+    }
+
+    // Colorize and upload only the parts of the grid that changed since the
+    // PBO slice was last written, the slices and the texture keep everything
+    // else from earlier frames
+    if(_backgroundDirty) {
+        // Burnt cells only change along with burning ones, unless they are
+        // shown or hidden as a whole
+        if(_window->paletteBackground() && (fireBurned != nullptr) != _backgroundBurned) {
+            _backgroundBurned = fireBurned != nullptr;
+            _backgroundRects.markAll();
+        }
+        if(_fireThread && fireGrid == &_fireThread->latest().grid) {
+            // Only chunks the thread copied since the last snapshot shown can differ
+            const std::vector<uint32_t> &versions = _fireThread->latest().chunkVersions;
+            const bool sameChunks = _backgroundLive && _shownChunkVersions.size() == versions.size();
+            if(!sameChunks) {
+                _backgroundRects.update(*fireGrid);
+                _shownChunkVersions = versions;
+            }
+            for(size_t chunk = 0; sameChunks && chunk < versions.size(); ++chunk) {
+                if(_shownChunkVersions[chunk] == versions[chunk])
+                    continue;
+                const int chunkX = static_cast<int>(chunk) % _fire.chunksX();
+                const int chunkY = static_cast<int>(chunk) / _fire.chunksX();
+                _backgroundRects.update(*fireGrid, Rect{chunkX * FireSimulation::TileSize, chunkY * FireSimulation::TileSize,
+                                                        FireSimulation::TileSize, FireSimulation::TileSize});
+                _shownChunkVersions[chunk] = versions[chunk];
+            }
+            _backgroundLive = true;
+        } else {
+            _backgroundRects.update(*fireGrid);
+            _backgroundLive = false;
+        }
+        const int slice = _window->pboSlice();
+        if(!_backgroundRects.empty(slice)) {
+            const std::vector<Rect> &rects = _backgroundRects.rects(slice);
+            GLubyte *ptr = _window->mapPBO();
+            if(ptr) {
+                for(const Rect &rect: rects) {
+                    if(_window->paletteBackground())
+                        indexFireGrid(*fireGrid, fireBurned, ptr, rect);
+                    else
+                        colorizeFireGrid(*fireGrid, ptr, rect);
+                }
+                _window->unmapPBO();
+                _window->updateTextureFromPBO(rects);
+                _backgroundRects.clear(slice);
+            }
+        }
+        _backgroundDirty = false;
+    }
+
+    _window->drawBackground();
+
+    // Static entities go on a lower layer than moving ones, the batch keeps
+    // that order by submitting them first
+    if(_instancedSprites) {
+        InstancedSpriteBatch &sprites = _window->instancedSprites();
+        sprites.begin();
+        submitEntities(deltaTime, [&](float x, float y, float width, float height, const Texture &texture, int layer) {
+            sprites.submit(x, y, width, height, texture, UvRect(), layer);
+        });
+        sprites.end();
+    } else {
+        SpriteBatch &sprites = _window->spriteBatch();
+        sprites.begin();
+        submitEntities(deltaTime, [&](float x, float y, float width, float height, const Texture &texture, int) {
+            sprites.submit(x, y, width, height, texture);
+        });
+        sprites.end();
     }
 }
 